@@ -1,13 +1,10 @@
-		AREA myData, DATA, READWRITE	
-;global variable in assembly			
-OrigStackPointer DCD 0x00
-		
 		AREA myProg, CODE, READONLY
 ;export assembly functions			
 		EXPORT process_terminated
 		EXPORT process_begin
 		EXPORT process_blocked
 		EXPORT PIT0_IRQHandler
+		EXPORT PendSV_Handler
 		EXPORT SVC_Handler
 ;import C functions
 		IMPORT process_select
@@ -18,9 +15,16 @@ OrigStackPointer DCD 0x00
 TFLG     EQU 0x4003710C ; TFLG address
 CTRL     EQU 0x40037108 ; Ctrl address
 SHCSR    EQU 0xE000ED20
+FPCCR    EQU 0xE000EF34 ; FP context control, bit 0 = LSPACT
+ICSR     EQU 0xE000ED04 ; Interrupt control and state
+PENDSVSET EQU 0x10000000
 	
 SVC_Handler
-	LDR  R1, [SP,#24] ; Read PC of SVC instruction
+	TST  LR, #0x4	  ; Caller's frame: on the PSP for a process,
+	ITE  EQ			  ; on the MSP for main
+	MRSEQ R0, MSP
+	MRSNE R0, PSP
+	LDR  R1, [R0,#24] ; Read PC of SVC instruction
 	LDRB R0, [R1,#-2] ; Get #N from SVC instruction
 	ADR  R1, SVC_Table
 	LDR  PC, [R1,R0,LSL #2] ; Branch to Nth SVC routine
@@ -28,15 +32,26 @@ SVC_Handler
 SVC_Table
 	DCD SVC0_begin
 	DCD SVC1_terminate
-	DCD PIT0_IRQHandler ; Use system tick as SVC2 handler
 
 SVC0_begin
-				PUSH {R4-R11,LR}
-				;******* Store Original Stack Pointer ********
-				LDR R1, =OrigStackPointer
-				STR SP, [R1]
-				;********************************************
+				CPSID i 			; Disable all interrupts: PIT1 must not touch the
+									; ready queues or the timers under process_select
+				; Save the context of main on the MSP, where the kernel runs. It
+				; stays there, just above every handler frame, until the last
+				; process is gone.
+				TST LR, #0x10		; EXC_RETURN bit 4 clear: main used the FPU
+				IT EQ
+				VPUSHEQ {S16-S31}	; its S0-S15 are lazily stacked by hardware
+				PUSH {R4-R12,LR}	; R12 keeps the MSP 8-byte aligned
 SVC1_terminate
+				CPSID i 			; Disable all interrupts (for process_select, as in
+									; PendSV; resume_process enables them again)
+				; A terminated process may still owe a lazy save of S0-S15
+				; into its frame, on a stack that is about to be freed: drop it.
+				LDR R1, =FPCCR
+				LDR R0, [R1]
+				BIC R0, R0, #1
+				STR R0, [R1]
 				
 				MOVS R0, #0
 				B do_process_select
@@ -53,35 +68,59 @@ process_begin
 
 				
 process_blocked
-				CPSIE i ; Enable global interrupts, just in case   
-				SVC #2 ; SVC2 = process blocked        
+				LDR R0, =ICSR
+				LDR R1, =PENDSVSET
+				STR R1, [R0]	; Pend the switch
+				CPSIE i 		; Enable global interrupts: PendSV is taken here
+				ISB
 				BX LR
 				
-PIT0_IRQHandler ; Timer Interrupt
-			  CPSID i 			; Disable all interrupts 
-			  PUSH {R4-R11,LR} 	; save registers
-			  ;----store scheduling timer state----
-			  LDR R1, =CTRL
-			  LDR R0, [R1]
-			  PUSH {R0}
-
-				;---clear the interrupt flag----
-				LDR  R4, =TFLG
+PIT0_IRQHandler ; Timer Interrupt: end of the quantum
+				LDR  R0, =TFLG
 				MOVS R1, #1	
-				STR  R1, [R4]
-			  ;-------------------------------
+				STR  R1, [R0]	; clear the interrupt flag
+				LDR  R0, =ICSR
+				LDR  R1, =PENDSVSET
+				STR  R1, [R0]	; pend the switch
+				BX LR
 				
-				;move sp to r0 to prepare for process_select 
-				MOV R0, SP 
+PendSV_Handler ; Context switch, at the lowest priority so that it runs once
+			   ; no other handler is active, however many of them pended it
+				TST LR, #0x4		; Only switch away from a process (PSP),
+				IT EQ				; never from main
+				BXEQ LR
+				CPSID i 			; Disable all interrupts 
+				;---- where the context will be saved on the process stack:
+				;---- [R4-R11][LR][S16-S31 if the process used the FPU]
+				MRS R0, PSP
+				TST LR, #0x10		; EXC_RETURN bit 4 clear: the process used the FPU
+				ITE EQ
+				SUBEQ R0, R0, #100
+				SUBNE R0, R0, #36
+				PUSH {R0,LR}
+				BL process_select	; R4-R11 and S16-S31 are preserved across the call
+				POP {R1,LR}
+				CMP R0, R1
+				BNE switch_process
+				;---- same process: nothing was saved, nothing to restore
+				CPSIE I
+				BX LR
+				
+switch_process
+				;---- save the context where process_select was told it is
+				MRS R2, PSP
+				TST LR, #0x10
+				IT EQ
+				VSTMDBEQ R2!, {S16-S31}	; save FP registers (this also makes the
+										; hardware save the lazily stacked S0-S15)
+				STMDB R2!, {R4-R11,LR}	; save registers
+				B process_selected
 				
 do_process_select
-				;******* Load Original Stack Pointer ********
-				; We want the process select function to run on the "main" stack
-				; This helps reduce funkiness when a process stack is too small and process_select overwrites other memory
-				LDR R1, =OrigStackPointer
-				LDR SP, [R1]
-				;********************************************
+				; process_select runs on the MSP, so a process stack that is too
+				; small cannot corrupt it
 				BL process_select	;Process_select returns 0 if there are no processes left
+process_selected
 				CMP R0, #0
 				BNE resume_process	;take branch if there are more processes
 				
@@ -90,15 +129,19 @@ do_process_select
 				MOVS R0, #0
 				STR R0, [R1]
 				
-				POP {R4-R11,PC} ; Restore calle-save state and return
+				POP {R4-R12,LR} ; Restore calle-save state of main and return
+				TST LR, #0x10
+				IT EQ
+				VPOPEQ {S16-S31}
+				CPSIE I ; main called process_start with interrupts enabled
+				BX LR
 				
 resume_process 
-				MOV SP, R0    ;switch stacks
-				;---- restore scheduling timer state
-				POP {R0}
-			    LDR R1, =CTRL
-			    STR R0, [R1]
-				
+				LDMIA R0!, {R4-R11,LR}	; Restore registers that aren't saved by interrupt
+				TST LR, #0x10			; FP frame: restore FP registers too
+				IT EQ
+				VLDMIAEQ R0!, {S16-S31}
+				MSR PSP, R0				; switch stacks
 				CPSIE I ; Enable global interrupts before returning from handler
-				POP {R4-R11,PC} ; Restore registers that aren't saved by interrupt, and return from interrupt
+				BX LR	; return from interrupt, on the PSP
 				END
@@ -26,19 +26,54 @@
   |-----------------|
   |    R3 - R0      |
 	|-----------------|
-  |   0xFFFFFFF9    | <--- exception return value 
+  |   0xFFFFFFFD    | <--- exception return value (thread mode, PSP)
   |-----------------|
   |    R4 - R11     |
   |-----------------|
-  |    PIT State    |
-  |-----------------|
 
 
-  State requires 18 slots on the stack.
+  State requires 17 slots on the stack. PIT0 is not part of it: every
+  process shares one quantum, and process_select only reprograms PIT0
+  for processes that set their own (process_set_quantum).
+
+  Once a process has used the FPU, its exception return value has bit 4
+  clear and the frame grows: the hardware adds S0-S15 and FPSCR (18
+  words) above xPSR, and the context switch saves S16-S31 (16 words)
+  between R0-R3 and the exception return value. Integer-only processes
+  keep the 17-slot frame.
+
+  Processes run in thread mode on the PSP, which points at this frame
+  while they are switched out. The kernel (process_select and the
+  interrupt handlers) always runs on the MSP.
 
  */
 
 
+#define FRAME_WORDS PROCESS_FRAME_WORDS
+
+/*------------------------------------------------------------------------
+ *
+ *  process_frame_init --
+ *
+ *   Write the initial context frame into the FRAME_WORDS words at frame
+ *
+ *------------------------------------------------------------------------
+ */
+
+static void process_frame_init (unsigned int *frame, void (*f)(void))
+{
+	int i;
+
+	for (i=0; i < FRAME_WORDS; i++) {
+		frame[i] = 0;
+	}
+
+	frame[16] = 0x01000000; // xPSR
+	frame[15] = (unsigned int) f; // PC
+	frame[14] = (unsigned int) process_terminated; // LR
+	frame[8]  = 0xFFFFFFFD; // EXC_RETURN value, returns to thread mode on the PSP
+}
+
 /*------------------------------------------------------------------------
  *
  *  process_stack_init --
@@ -54,8 +89,8 @@ unsigned int * process_stack_init (void (*f)(void), int n)
 	
 	int i;
 
-	/* in reality, there are 18 more slots needed for stored context */
-	n += 18;
+	/* in reality, there are 17 more slots needed for stored context */
+	n += FRAME_WORDS;
 		
   /* Allocate space for the process's stack */
   sp = malloc(n*sizeof(int));
@@ -64,17 +99,29 @@ unsigned int * process_stack_init (void (*f)(void), int n)
   
   /* Initialize the stack to all zeros */ 
   /* Note: Could just use calloc instead */ 
-  for (i=0; i < n; i++) {
+  for (i=0; i < n - FRAME_WORDS; i++) {
   	sp[i] = 0;
   }
   
-	sp[n-1] = 0x01000000; // xPSR
-  sp[n-2] = (unsigned int) f; // PC
-	sp[n-3] = (unsigned int) process_terminated; // LR
-	sp[n-9] = 0xFFFFFFF9; // EXC_RETURN value, returns to thread mode
-	sp[n-18] = 0x3; // Enable scheduling timer and interrupt
+	process_frame_init(&(sp[n-FRAME_WORDS]), f);
   
-  return &(sp[n-18]);
+  return &(sp[n-FRAME_WORDS]);
+}
+
+/*------------------------------------------------------------------------
+ *
+ *  process_stack_reset --
+ *
+ *   Rewind a stack allocated by process_stack_init so that the process
+ * starts over at f. Call this with the SP which was returned by
+ * process_stack_init; it returns that same SP. No memory is allocated.
+ *
+ *------------------------------------------------------------------------
+ */
+unsigned int * process_stack_reset (unsigned int *sp, void (*f)(void))
+{
+	process_frame_init(sp, f);
+	return sp;
 }
 
 /*------------------------------------------------------------------------
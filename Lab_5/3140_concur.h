@@ -39,8 +39,11 @@ typedef struct process_state process_t;
 
 /* Called by the runtime system to select another process.
    "cursp" = the stack pointer for the currently running process
+	 (its saved PSP). Runs on the main stack (MSP).
 	 cursp will be NULL when first starting the scheduler, and when a process terminates
 	 Return the stack pointer for the new process to run, or NULL to exit the scheduler.
+	 Returning cursp itself resumes the running process on a fast path: its
+	 registers are only written to cursp once another process is chosen.
 */
 extern unsigned int * process_select (unsigned int * cursp);
 
@@ -56,6 +59,12 @@ void process_start (void);
 /* Create a new process. Return -1 if creation failed */
 int process_create (void (*f)(void), int n);
 
+/* Create a new process with a fixed priority from 0 (highest) to 31
+   (lowest, the priority of process_create). Priorities are only used by the
+   SCHED_FP scheduling policy. Return -1 if creation failed or prio is out
+   of range */
+int process_create_prio (void (*f)(void), int n, int prio);
+
 static void process_free(process_t *proc);
 
 int process_rt_create(void (*f)(void), int n, realtime_t *start, realtime_t *deadline);
@@ -68,13 +77,21 @@ You may use the following functions that we have provided
 
 
 /* This function can ONLY BE CALLED if interrupts are disabled.
-   This function switches execution to the next ready process, and is
-   also the entry point for the timer interrupt.
+   This function switches execution to the next ready process: it pends
+   the context switch (PendSV) and enables interrupts.
    
    Implemented in 3140.s
 */
 extern void process_blocked (void);
 
+/* Asks for the running process to be preempted, e.g. because a process
+   that should run first was just made ready. Safe from interrupt
+   handlers: the switch happens in PendSV, at the lowest priority, once
+   interrupts are enabled and no other handler is active. Several
+   requests before then make a single switch.
+*/
+#define process_reschedule() (SCB->ICSR = SCB_ICSR_PENDSVSET_Msk)
+
 /*
   This function is called by user code indirectly when the process
   terminates. This is handled by stack manipulation.
@@ -86,6 +103,14 @@ extern void process_blocked (void);
 */
 extern void process_terminated (void);
 
+/* Number of words in the initial context frame of a process */
+#define PROCESS_FRAME_WORDS 17
+
+/* Extra stack words taken by the context of a process that uses the FPU:
+   S0-S15 and FPSCR stacked by hardware, S16-S31 by the context switch.
+   Add them to n for processes doing floating-point math. */
+#define PROCESS_FPU_FRAME_WORDS 34
+
 /* This function can ONLY BE CALLED if interrupts are disabled. It
    does not modify interrupt flags.
 	 
@@ -95,6 +120,18 @@ extern void process_terminated (void);
 */
 unsigned int * process_stack_init (void (*f)(void), int n);
 
+/* This function can ONLY BE CALLED if interrupts are disabled. It
+   does not modify interrupt flags.
+	 
+	 Rebuilds the initial state of a stack allocated in process_stack_init,
+	 so that the process restarts at f. sp must be the value returned by
+	 process_stack_init. Used to recycle the stack of periodic processes.
+	 Also builds a fresh frame at any PROCESS_FRAME_WORDS words at sp.
+	 
+	 Implemented in 3140_concur.c
+*/
+unsigned int * process_stack_reset (unsigned int *sp, void (*f)(void));
+
 /* This function can ONLY BE CALLED if interrupts are disabled. It
    does not modify interrupt flags.
 	 
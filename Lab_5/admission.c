@@ -0,0 +1,126 @@
+#include "admission.h"
+
+// Utilization is kept in fixed point with this many fractional bits.
+#define U_SHIFT 16
+#define U_ONE 	(1u << U_SHIFT)
+
+//-------------------------------------------------------------------
+// gcd --------------------------------------------------------------
+//-------------------------------------------------------------------
+static unsigned long long gcd(unsigned long long a, unsigned long long b) {
+	while (b) {
+		unsigned long long t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+//-------------------------------------------------------------------
+// demand -----------------------------------------------------------
+//-------------------------------------------------------------------
+// Processor demand of all tasks in [0, t]: the execution time of every
+// job with both release and deadline inside the interval.
+static unsigned long long demand(const rt_task_t *tasks, int n, unsigned int t) {
+	unsigned long long total = 0;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		if (t < tasks[i].deadline) continue;
+		if (tasks[i].period == 0) {
+			total += tasks[i].wcet;
+		} else {
+			total += (unsigned long long)((t - tasks[i].deadline) / tasks[i].period + 1) * tasks[i].wcet;
+		}
+	}
+	return total;
+}
+
+//-------------------------------------------------------------------
+// admission_edf ----------------------------------------------------
+//-------------------------------------------------------------------
+int admission_edf(const rt_task_t *tasks, int n) {
+	unsigned long long u = 0;			// utilization, rounded up
+	unsigned long long slack = 0;	// sum of (T - D) * U over constrained tasks
+	unsigned long long hyper = 1;	// hyperperiod, saturated
+	unsigned int max_deadline = 0;
+	int constrained = 0;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		const rt_task_t *task = &tasks[i];
+		if (task->wcet > task->deadline) return 0;
+		if (task->deadline > max_deadline) max_deadline = task->deadline;
+
+		if (task->period == 0) {
+			constrained = 1;
+			continue;
+		}
+		unsigned long long ui = (((unsigned long long)task->wcet << U_SHIFT) + task->period - 1) / task->period;
+		u += ui;
+		if (task->deadline < task->period) {
+			constrained = 1;
+			slack += (task->period - task->deadline) * ui;
+		}
+		if (hyper <= 0xFFFFFFFFull) {
+			hyper = hyper / gcd(hyper, task->period) * task->period;
+		}
+	}
+
+	if (u > U_ONE) return 0;
+	// Implicit (or longer) deadlines everywhere: utilization is exact.
+	if (!constrained) return 1;
+
+	// Only deadlines up to L need to be checked: the hyperperiod plus the
+	// longest deadline always works, and for U < 1 the busy-period bound
+	// sum((T - D) * U) / (1 - U) is usually much shorter.
+	unsigned long long limit = hyper + max_deadline;
+	if (u < U_ONE) {
+		unsigned long long la = slack / (U_ONE - u);
+		if (la < max_deadline) la = max_deadline;
+		if (la < limit) limit = la;
+	}
+	if (limit > 0xFFFFFFFFull) limit = 0xFFFFFFFFull;
+
+	// Check the demand at every absolute deadline up to the limit.
+	int points = 0;
+	for (i = 0; i < n; i++) {
+		unsigned long long d = tasks[i].deadline;
+		while (d <= limit) {
+			if (++points > ADMISSION_MAX_POINTS) return 0;
+			if (demand(tasks, n, (unsigned int)d) > d) return 0;
+			if (tasks[i].period == 0) break;
+			d += tasks[i].period;
+		}
+	}
+	return 1;
+}
+
+//-------------------------------------------------------------------
+// admission_fp -----------------------------------------------------
+//-------------------------------------------------------------------
+int admission_fp(const rt_task_t *tasks, int n) {
+	int i, j;
+
+	for (i = 0; i < n; i++) {
+		unsigned long long r = tasks[i].wcet;
+		unsigned long long prev = 0;
+
+		// Iterate R = C_i + sum over higher priority j of ceil(R / T_j) * C_j
+		// until it settles or passes the deadline.
+		while (r != prev) {
+			if (r > tasks[i].deadline) return 0;
+			prev = r;
+			r = tasks[i].wcet;
+			for (j = 0; j < n; j++) {
+				if (j == i || tasks[j].prio > tasks[i].prio) continue;
+				if (tasks[j].period == 0) {
+					r += tasks[j].wcet;
+				} else {
+					r += (prev + tasks[j].period - 1) / tasks[j].period * tasks[j].wcet;
+				}
+			}
+		}
+	}
+	return 1;
+}
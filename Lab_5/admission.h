@@ -0,0 +1,39 @@
+#ifndef __ADMISSION_H__
+#define __ADMISSION_H__
+
+/**
+ * Schedulability tests used to admit real-time processes. This file only
+ * does arithmetic on task parameters, so it does not depend on the device
+ * headers and can be compiled on its own.
+ */
+
+/**
+ * Parameters of one real-time task, all in the same time unit (us).
+ * period is 0 for a one-shot job, which is assumed to be released at the
+ * same time as everything else (the worst case).
+ * prio is only used by admission_fp: a lower value is a higher priority.
+ */
+typedef struct {
+	unsigned int wcet;
+	unsigned int deadline;
+	unsigned int period;
+	unsigned int prio;
+} rt_task_t;
+
+/* Largest number of deadlines the EDF demand-bound check will examine
+   before giving up and rejecting the task set. */
+#ifndef ADMISSION_MAX_POINTS
+#define ADMISSION_MAX_POINTS 4096
+#endif
+
+/* Returns 1 if the n tasks are schedulable under EDF, 0 otherwise.
+   Checks utilization, then the processor demand bound when some relative
+   deadline is shorter than its period. */
+int admission_edf(const rt_task_t *tasks, int n);
+
+/* Returns 1 if the n tasks are schedulable under fixed priorities, 0
+   otherwise, using response-time analysis. Tasks with equal prio are
+   assumed to be able to delay each other. */
+int admission_fp(const rt_task_t *tasks, int n);
+
+#endif
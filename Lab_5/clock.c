@@ -0,0 +1,102 @@
+#include "realtime.h"
+#include <fsl_device_registers.h>
+
+/*
+  The system clock is PIT2 and PIT3 chained into a free-running 64-bit
+  down-counter clocked at CLOCK_HZ: PIT3 counts the wraps of PIT2. Both
+  reload with 0xFFFFFFFF, so the cycles elapsed since clock_init are the
+  complement of the 64-bit count. Nothing interrupts to keep time; it is
+  read on demand.
+
+  A 64-bit read is two 32-bit loads. Reading the high word, the low word
+  and the high word again catches a borrow from PIT2 into PIT3 in between,
+  so a read is never torn and needs no interrupt masking.
+ */
+#define CLOCK_LO 	2
+#define CLOCK_HI 	3
+
+static int clock_running = 0;
+
+//-------------------------------------------------------------------
+// clock_init -------------------------------------------------------
+//-------------------------------------------------------------------
+void clock_init(void) {
+	if (clock_running) return;
+
+	SIM->SCGC6 |= SIM_SCGC6_PIT_MASK;
+	PIT->MCR 		= 0;
+
+	// Start the high half first so it sees every wrap of the low half.
+	PIT->CHANNEL[CLOCK_HI].LDVAL = 0xFFFFFFFF;
+	PIT->CHANNEL[CLOCK_HI].TCTRL = PIT_TCTRL_CHN_MASK | PIT_TCTRL_TEN_MASK;
+	PIT->CHANNEL[CLOCK_LO].LDVAL = 0xFFFFFFFF;
+	PIT->CHANNEL[CLOCK_LO].TCTRL = PIT_TCTRL_TEN_MASK;
+	clock_running = 1;
+}
+
+//-------------------------------------------------------------------
+// clock_cycles -----------------------------------------------------
+//-------------------------------------------------------------------
+uint64_t clock_cycles(void) {
+	uint32_t hi, lo;
+
+	// The PIT registers must not be touched before the module is clocked.
+	if (!clock_running) return 0;
+	do {
+		hi = PIT->CHANNEL[CLOCK_HI].CVAL;
+		lo = PIT->CHANNEL[CLOCK_LO].CVAL;
+	} while (hi != PIT->CHANNEL[CLOCK_HI].CVAL);
+	return ~(((uint64_t) hi << 32) | lo);
+}
+
+//-------------------------------------------------------------------
+// cycles_to_systime ------------------------------------------------
+//-------------------------------------------------------------------
+// CLOCK_HZ need not be a multiple of SYSTIME_HZ, so whole seconds and
+// the remainder are converted separately: exact, and no overflow.
+systime_t cycles_to_systime(uint64_t cycles) {
+	uint64_t sec 	= cycles / CLOCK_HZ;
+	uint32_t rem 	= (uint32_t) (cycles - sec * CLOCK_HZ);
+	return sec * SYSTIME_HZ + (uint64_t) rem * SYSTIME_HZ / CLOCK_HZ;
+}
+
+//-------------------------------------------------------------------
+// systime_to_cycles ------------------------------------------------
+//-------------------------------------------------------------------
+uint64_t systime_to_cycles(systime_t time) {
+	uint64_t sec 	= time / SYSTIME_HZ;
+	uint32_t rem 	= (uint32_t) (time - sec * SYSTIME_HZ);
+	return sec * CLOCK_HZ + ((uint64_t) rem * CLOCK_HZ + SYSTIME_HZ - 1) / SYSTIME_HZ;
+}
+
+//-------------------------------------------------------------------
+// process_time -----------------------------------------------------
+//-------------------------------------------------------------------
+systime_t process_time(void) {
+	return cycles_to_systime(clock_cycles());
+}
+
+//-------------------------------------------------------------------
+// process_current_time ---------------------------------------------
+//-------------------------------------------------------------------
+realtime_t process_current_time(void) {
+	realtime_t t;
+	systime_to_realtime(process_time(), &t);
+	return t;
+}
+
+//-------------------------------------------------------------------
+// realtime_to_systime ----------------------------------------------
+//-------------------------------------------------------------------
+systime_t realtime_to_systime(const realtime_t *t) {
+	return ((systime_t) t->sec * 1000 + t->msec) * (SYSTIME_HZ / 1000);
+}
+
+//-------------------------------------------------------------------
+// systime_to_realtime ----------------------------------------------
+//-------------------------------------------------------------------
+void systime_to_realtime(systime_t time, realtime_t *t) {
+	time 		/= SYSTIME_HZ / 1000;
+	t->sec 	= (unsigned int) (time / 1000);
+	t->msec = (unsigned int) (time % 1000);
+}
@@ -0,0 +1,60 @@
+/*************************************************************************
+ *
+ *  Host stand-in for the device header, for the tests in this directory.
+ *
+ *  Only what the kernel headers and the host-tested sources use: the
+ *  CMSIS intrinsics become plain C, and interrupt masking is a no-op
+ *  (host tests run the code from a single context, or use a ring that
+ *  needs no masking).
+ *
+ **************************************************************************
+ */
+#ifndef __HOST_FSL_DEVICE_REGISTERS_H__
+#define __HOST_FSL_DEVICE_REGISTERS_H__
+
+#include <stdint.h>
+
+#define DEFAULT_SYSTEM_CLOCK 20971520u
+
+static inline uint8_t __CLZ(uint32_t x) {
+	return x ? (uint8_t) __builtin_clz(x) : 32;
+}
+
+static inline uint32_t __RBIT(uint32_t x) {
+	uint32_t r = 0;
+	int i;
+	for (i = 0; i < 32; i++) {
+		r = (r << 1) | (x & 1);
+		x >>= 1;
+	}
+	return r;
+}
+
+static inline void __DMB(void) {
+	__sync_synchronize();
+}
+
+// Only ICSR, so that process_reschedule() leaves a trace tests can check.
+typedef struct {
+	volatile uint32_t ICSR;
+} SCB_Type;
+
+#define SCB_ICSR_PENDSVSET_Msk (1u << 28)
+
+__attribute__((weak)) SCB_Type host_scb;
+#define SCB (&host_scb)
+
+// Exclusive accesses from a single context always succeed.
+static inline uint32_t __LDREXW(volatile uint32_t *addr) { return *addr; }
+static inline uint32_t __STREXW(uint32_t value, volatile uint32_t *addr) {
+	*addr = value;
+	return 0;
+}
+static inline void __CLREX(void) {}
+
+static inline uint32_t __get_PRIMASK(void) { return 0; }
+static inline void __set_PRIMASK(uint32_t m) { (void) m; }
+static inline void __disable_irq(void) {}
+static inline void __enable_irq(void) {}
+
+#endif
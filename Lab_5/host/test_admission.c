@@ -0,0 +1,98 @@
+/*************************************************************************
+ * Admission control test
+ *
+ *   Hand-worked task sets for admission_edf (utilization, then the
+ *   processor demand bound for constrained deadlines) and admission_fp
+ *   (response-time analysis). Each set is written {wcet, deadline,
+ *   period, prio}; the comment gives the figure the verdict rests on.
+ *
+ ************************************************************************/
+
+#include <stdio.h>
+#include "admission.h"
+
+#define N(set) ((int) (sizeof(set) / sizeof(set[0])))
+
+int errors = 0;
+
+void expect(const char *name, int got, int want) {
+	if (got != want) {
+		printf("FAIL: %s: got %d, expected %d\n", name, got, want);
+		errors++;
+	}
+}
+
+/*-----*/
+/* EDF */
+/*-----*/
+
+// U = 1/4 + 2/6 + 1/8 = 0.71
+const rt_task_t edf_implicit[] = { {1, 4, 4, 0}, {2, 6, 6, 0}, {1, 8, 8, 0} };
+// U = 2/4 + 3/6 = 1 exactly
+const rt_task_t edf_full[] = { {2, 4, 4, 0}, {3, 6, 6, 0} };
+// U = 3/4 + 2/6 = 1.08
+const rt_task_t edf_over[] = { {3, 4, 4, 0}, {2, 6, 6, 0} };
+// U = 0.4, but both jobs are due by t = 3 and need 4
+const rt_task_t edf_constrained_fail[] = { {2, 2, 10, 0}, {2, 3, 10, 0} };
+// U = 0.3; demand is 1 at t = 2, 3 at t = 5, 4 at 12, 6 at 15, ...
+const rt_task_t edf_constrained_ok[] = { {1, 2, 10, 0}, {2, 5, 10, 0} };
+// U = 0.85, but at t = 9 the demand is 2 * 2 + 3 + 3 = 10
+const rt_task_t edf_constrained_late[] = { {2, 4, 5, 0}, {3, 5, 10, 0}, {3, 9, 20, 0} };
+// wcet beyond the deadline
+const rt_task_t edf_wcet_too_long[] = { {5, 4, 10, 0} };
+// One-shot jobs released together, due at t = 5: 2 + 3 fits, 3 + 3 does not
+const rt_task_t edf_oneshot_ok[] = { {2, 5, 0, 0}, {3, 5, 0, 0} };
+const rt_task_t edf_oneshot_fail[] = { {3, 5, 0, 0}, {3, 5, 0, 0} };
+// us-sized parameters (past 16 bits): U = 0.7 + 0.2 = 0.9
+const rt_task_t edf_us[] = { {70000, 100000, 100000, 0}, {40000, 200000, 200000, 0} };
+// us-sized, constrained: U = 0.43, demand 120000 by t = 100000
+const rt_task_t edf_us_fail[] = { {70000, 100000, 400000, 0}, {50000, 100000, 200000, 0} };
+
+/*----------------*/
+/* Fixed priority */
+/*----------------*/
+
+// R1 = 3, R2 = 6, R3 = 5 + 3 * 3 + 2 * 3 = 20 <= 20
+const rt_task_t fp_ok[] = { {3, 7, 7, 0}, {3, 12, 12, 1}, {5, 20, 20, 2} };
+// Same with C3 = 6: R3 = 6 + 3 * 3 + 2 * 3 = 21 > 20
+const rt_task_t fp_fail[] = { {3, 7, 7, 0}, {3, 12, 12, 1}, {6, 20, 20, 2} };
+// U = 1, harmonic: R2 = 2 + 2 * 1 = 4 <= 4, past the Liu & Layland bound
+const rt_task_t fp_harmonic[] = { {1, 2, 2, 0}, {2, 4, 4, 1} };
+// Priorities listed out of order: the same set as fp_ok
+const rt_task_t fp_unordered[] = { {5, 20, 20, 2}, {3, 7, 7, 0}, {3, 12, 12, 1} };
+// Equal priorities delay each other: 2 + 2 > 3
+const rt_task_t fp_equal[] = { {2, 3, 3, 4}, {2, 3, 3, 4} };
+// Constrained deadline on the low priority task: R2 = 2 + 2 = 4 > 3
+const rt_task_t fp_constrained[] = { {2, 5, 5, 0}, {2, 3, 10, 1} };
+// A one-shot high-priority job counts once: R2 = 3 + 4 = 7 <= 8
+const rt_task_t fp_oneshot[] = { {4, 10, 0, 0}, {3, 8, 8, 1} };
+
+int main(void) {
+	expect("edf_implicit", 						admission_edf(edf_implicit, N(edf_implicit)), 1);
+	expect("edf_full", 								admission_edf(edf_full, N(edf_full)), 1);
+	expect("edf_over", 								admission_edf(edf_over, N(edf_over)), 0);
+	expect("edf_constrained_fail", 		admission_edf(edf_constrained_fail, N(edf_constrained_fail)), 0);
+	expect("edf_constrained_ok", 			admission_edf(edf_constrained_ok, N(edf_constrained_ok)), 1);
+	expect("edf_constrained_late", 		admission_edf(edf_constrained_late, N(edf_constrained_late)), 0);
+	expect("edf_wcet_too_long", 			admission_edf(edf_wcet_too_long, N(edf_wcet_too_long)), 0);
+	expect("edf_oneshot_ok", 					admission_edf(edf_oneshot_ok, N(edf_oneshot_ok)), 1);
+	expect("edf_oneshot_fail", 				admission_edf(edf_oneshot_fail, N(edf_oneshot_fail)), 0);
+	expect("edf_us", 									admission_edf(edf_us, N(edf_us)), 1);
+	expect("edf_us_fail", 						admission_edf(edf_us_fail, N(edf_us_fail)), 0);
+	expect("edf_empty", 							admission_edf(edf_us, 0), 1);
+
+	expect("fp_ok", 									admission_fp(fp_ok, N(fp_ok)), 1);
+	expect("fp_fail", 								admission_fp(fp_fail, N(fp_fail)), 0);
+	expect("fp_harmonic", 						admission_fp(fp_harmonic, N(fp_harmonic)), 1);
+	expect("fp_unordered", 						admission_fp(fp_unordered, N(fp_unordered)), 1);
+	expect("fp_equal", 								admission_fp(fp_equal, N(fp_equal)), 0);
+	expect("fp_constrained", 					admission_fp(fp_constrained, N(fp_constrained)), 0);
+	expect("fp_oneshot", 							admission_fp(fp_oneshot, N(fp_oneshot)), 1);
+
+	if (errors) {
+		printf("FAIL: %d task set(s)\n", errors);
+		return 1;
+	}
+	printf("ok\n");
+	return 0;
+}
@@ -0,0 +1,278 @@
+/*************************************************************************
+ * Condition variable test
+ *
+ *   Drives c_wait / c_signal / c_broadcast in lock.c on a single host
+ *   thread. process_blocked is where a real switch would happen, and
+ *   the first point where anything else can run once c_wait has
+ *   released the lock: the stub runs the next scheduled "process body"
+ *   there, nested, and returns to the caller when it is done. So a
+ *   body scheduled before a c_wait runs exactly in the window between
+ *   the release and the waiter being switched out.
+ *
+ *   window_isr    an interrupt handler signals in the window, while the
+ *                 waiter is still current_process
+ *   window_owner  the release inside c_wait hands the lock to a
+ *                 process waiting for it, which signals at once
+ *   broadcast     three waiters, one broadcast wakes them all
+ *   spurious      a broadcast with the predicate still false: the
+ *                 waiter rechecks it, with the lock held, and waits
+ *                 again
+ *
+ *   lock_t stores the owner's process_t pointer in an int, as on the
+ *   32-bit target; the processes are mapped below 2 GB (MAP_32BIT) so
+ *   that it fits on a 64-bit host too.
+ *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <sys/mman.h>
+#include "shared_structs.h"
+#include "sched.h"
+#include "lock.h"
+
+#define NPROCS 	4
+#define SIGNALLER 	3
+
+process_t *procs;
+process_t * current_process = NULL;
+
+int ready[NPROCS];
+int errors = 0;
+
+#define CHECK(cond) do { 																\
+	if (!(cond)) { 																				\
+		printf("%s:%d: FAIL: %s\n", __FILE__, __LINE__, #cond); 	\
+		errors++; 																					\
+	} 																										\
+} while (0)
+
+#define owner(l) ((process_t *) ((l)->held & ~1))
+
+/*-----------------------------------------------*/
+/* Kernel stubs: a FIFO policy over ready flags  */
+/*-----------------------------------------------*/
+void fifo_enqueue(process_t *proc) { ready[proc - procs] = 1; }
+void fifo_remove(process_t *proc) { ready[proc - procs] = 0; }
+int fifo_precedes(process_t *a, process_t *b) { return 0; }
+process_t * fifo_dequeue_next(void) { return NULL; }
+
+const sched_policy_t sched_policy = {
+	fifo_enqueue,
+	fifo_dequeue_next,
+	NULL,
+	NULL,
+	fifo_remove,
+	fifo_precedes,
+	NULL
+};
+
+/*-----------------------------------------*/
+/* Kernel stubs: wait queues and switching */
+/*-----------------------------------------*/
+void process_wake(process_t *proc) {
+	proc->blocked = 0;
+	if (proc != current_process) sched_policy.enqueue(proc);
+}
+
+void park_process(process_t **head, process_t **tail, process_t *proc) {
+	proc->next = NULL;
+	if (*tail) (*tail)->next = proc; else *head = proc;
+	*tail = proc;
+}
+
+process_t * unpark_process(process_t **head, process_t **tail) {
+	process_t *proc = *head;
+	if (!proc) return NULL;
+	*head = proc->next;
+	if (!*head) *tail = NULL;
+	proc->next 				= NULL;
+	proc->blocked_on 	= NULL;
+	process_wake(proc);
+	return proc;
+}
+
+// Bodies to run at the next process_blocked calls, in order.
+void (*bodies[8])(void);
+int body_head = 0, body_tail = 0;
+
+void schedule_body(void (*body)(void)) {
+	bodies[body_tail++] = body;
+}
+
+void process_blocked(void) {
+	process_t *self = current_process;
+	if (body_head == body_tail) return;	// nothing else to run
+	bodies[body_head++]();
+	// Switched back: the caller must have been woken meanwhile.
+	CHECK(!self->blocked);
+	current_process = self;
+	ready[self - procs] = 0;
+}
+
+/*------------------*/
+/* Helper functions */
+/*------------------*/
+lock_t l;
+cond_t c;
+int predicate;
+int wakeups[NPROCS];
+int done[NPROCS];
+int woken;	// waiters made ready by the last broadcast
+
+void reset(void) {
+	int i;
+	for (i = 0; i < NPROCS; i++) {
+		process_t *proc = &procs[i];
+		proc->rt 					= 0;
+		proc->prio 				= 0;
+		proc->blocked 		= 0;
+		proc->blocked_on 	= NULL;
+		proc->locks_held 	= 0;
+		proc->inherited 	= 0;
+		proc->next 				= NULL;
+		ready[i] 		= 0;
+		wakeups[i] 	= 0;
+		done[i] 		= 0;
+	}
+	l_init(&l);
+	c_init(&l, &c);
+	predicate = 0;
+	body_head = body_tail = 0;
+}
+
+// The usual waiting loop, for procs[id].
+void waiter(int id) {
+	current_process = &procs[id];
+	l_lock(&l);
+	while (!predicate) {
+		c_wait(&l, &c);
+		// Back with the lock held, whatever woke us.
+		CHECK(owner(&l) == &procs[id]);
+		wakeups[id]++;
+	}
+	done[id] = 1;
+	l_unlock(&l);
+}
+
+// Signals in the window, from an interrupt handler: the waiter is
+// parked and current_process is still the waiter.
+void isr_signal(void) {
+	CHECK(c_waiting(&l, &c));
+	CHECK(owner(&l) == NULL);
+	predicate = 1;
+	c_signal(&l, &c);
+	CHECK(!c_waiting(&l, &c));
+}
+
+// Runs once c_wait's release handed it the lock it was waiting for.
+void owner_signal(void) {
+	current_process = &procs[SIGNALLER];
+	CHECK(owner(&l) == &procs[SIGNALLER]);
+	CHECK(c_waiting(&l, &c));
+	predicate = 1;
+	c_signal(&l, &c);
+	l_unlock(&l);
+}
+
+void waiter_1(void) { waiter(1); }
+void waiter_2(void) { waiter(2); }
+
+void broadcast(void) {
+	current_process = &procs[SIGNALLER];
+	l_lock(&l);
+	predicate = 1;
+	c_broadcast(&l, &c);
+	CHECK(!c_waiting(&l, &c));
+	woken = ready[0] + ready[1] + ready[2];
+	l_unlock(&l);
+}
+
+void broadcast_false(void) {
+	current_process = &procs[SIGNALLER];
+	l_lock(&l);
+	c_broadcast(&l, &c);
+	l_unlock(&l);
+}
+
+/*-------*/
+/* Tests */
+/*-------*/
+void test_window_isr(void) {
+	reset();
+	schedule_body(isr_signal);
+	waiter(0);
+	CHECK(done[0] && wakeups[0] == 1);
+	// Still current when woken: left for process_select to queue.
+	CHECK(!ready[0]);
+	CHECK(owner(&l) == NULL);
+}
+
+void test_window_owner(void) {
+	reset();
+	// procs[0] holds the lock, and the signaller blocks on it.
+	current_process = &procs[0];
+	l_lock(&l);
+	current_process = &procs[SIGNALLER];
+	l_lock(&l);
+	CHECK(procs[SIGNALLER].blocked && owner(&l) == &procs[0]);	// switched out
+
+	// procs[0] waits; the release wakes the signaller, which runs next.
+	schedule_body(owner_signal);
+	current_process = &procs[0];
+	while (!predicate) {
+		c_wait(&l, &c);
+		wakeups[0]++;
+	}
+	CHECK(owner(&l) == &procs[0]);
+	CHECK(wakeups[0] == 1);
+	l_unlock(&l);
+	CHECK(owner(&l) == NULL);
+}
+
+void test_broadcast(void) {
+	reset();
+	// Each waiter parks, and the next one runs in its window; the last
+	// window is the broadcaster's.
+	schedule_body(waiter_1);
+	schedule_body(waiter_2);
+	schedule_body(broadcast);
+	waiter(0);
+	CHECK(woken == 3);
+	CHECK(done[0] && done[1] && done[2]);
+	CHECK(wakeups[0] == 1 && wakeups[1] == 1 && wakeups[2] == 1);
+	CHECK(owner(&l) == NULL);
+}
+
+void test_spurious(void) {
+	reset();
+	// The first broadcast comes with the predicate still false: the
+	// waiter must wait again, and only leave on the second one.
+	schedule_body(broadcast_false);
+	schedule_body(broadcast);
+	waiter(0);
+	CHECK(woken == 1);
+	CHECK(done[0]);
+	CHECK(wakeups[0] == 2);
+	CHECK(owner(&l) == NULL);
+}
+
+int main(void) {
+	procs = mmap(NULL, NPROCS * sizeof(process_t), PROT_READ | PROT_WRITE,
+	             MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+	if (procs == MAP_FAILED) {
+		printf("FAIL: no memory below 2 GB\n");
+		return 1;
+	}
+
+	test_window_isr();
+	test_window_owner();
+	test_broadcast();
+	test_spurious();
+
+	if (errors) {
+		printf("FAIL: %d check(s)\n", errors);
+		return 1;
+	}
+	printf("ok\n");
+	return 0;
+}
@@ -0,0 +1,182 @@
+/*************************************************************************
+ * Priority inheritance test
+ *
+ *   The classic inversion, driven through lock.c: low takes the lock,
+ *   high blocks on it, then medium is released while low still holds
+ *   it. Built with LOCK_PRIO_INHERIT=1, low runs at high's priority
+ *   until it unlocks, so medium must not preempt it; with
+ *   LOCK_PRIO_INHERIT=0, medium preempts low and high waits behind
+ *   medium. Either way the unlock hands the lock to high, which runs
+ *   next, and low ends with its own priority.
+ *
+ *   The kernel side is stubbed below: a fixed-priority policy over an
+ *   array of ready flags, the wait queues, and a process_blocked that
+ *   only counts the switches it would cause.
+ *
+ *   lock_t stores the owner's process_t pointer in an int, as on the
+ *   32-bit target; the processes are mapped below 2 GB (MAP_32BIT) so
+ *   that it fits on a 64-bit host too.
+ *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <sys/mman.h>
+#include "shared_structs.h"
+#include "sched.h"
+#include "lock.h"
+
+enum { LOW, MEDIUM, HIGH, NPROCS };
+
+process_t *procs;
+process_t * current_process = NULL;
+
+int ready[NPROCS];
+int switches = 0;
+int errors = 0;
+
+#define CHECK(cond) do { 																\
+	if (!(cond)) { 																				\
+		printf("%s:%d: FAIL: %s\n", __FILE__, __LINE__, #cond); 	\
+		errors++; 																					\
+	} 																										\
+} while (0)
+
+/*------------------------------------------------*/
+/* Kernel stubs: fixed priority over ready flags  */
+/*------------------------------------------------*/
+void fp_enqueue(process_t *proc) { ready[proc - procs] = 1; }
+void fp_remove(process_t *proc) { ready[proc - procs] = 0; }
+int fp_precedes(process_t *a, process_t *b) { return a->prio < b->prio; }
+
+process_t * fp_dequeue_next(void) {
+	process_t *best = NULL;
+	int i;
+	for (i = 0; i < NPROCS; i++) {
+		if (ready[i] && (!best || fp_precedes(&procs[i], best))) best = &procs[i];
+	}
+	if (best) ready[best - procs] = 0;
+	return best;
+}
+
+const sched_policy_t sched_policy = {
+	fp_enqueue,
+	fp_dequeue_next,
+	NULL,
+	NULL,
+	fp_remove,
+	fp_precedes,
+	NULL
+};
+
+/*-----------------------------------------*/
+/* Kernel stubs: wait queues and switching */
+/*-----------------------------------------*/
+void process_wake(process_t *proc) {
+	proc->blocked = 0;
+	if (proc != current_process) sched_policy.enqueue(proc);
+}
+
+void park_process(process_t **head, process_t **tail, process_t *proc) {
+	process_t *prev = NULL;
+	process_t *itr 	= *head;
+	while (itr && !sched_policy.precedes(proc, itr)) {
+		prev = itr;
+		itr  = itr->next;
+	}
+	proc->next = itr;
+	if (prev) prev->next = proc; else *head = proc;
+	if (!itr) *tail = proc;
+}
+
+process_t * unpark_process(process_t **head, process_t **tail) {
+	process_t *proc = *head;
+	if (!proc) return NULL;
+	*head = proc->next;
+	if (!*head) *tail = NULL;
+	proc->next 				= NULL;
+	proc->blocked_on 	= NULL;
+	process_wake(proc);
+	return proc;
+}
+
+void process_blocked(void) {
+	switches++;
+}
+
+/*------------------*/
+/* Helper functions */
+/*------------------*/
+void init_proc(int i, int prio) {
+	process_t *proc = &procs[i];
+	proc->rt 					= 0;
+	proc->prio 				= prio;
+	proc->blocked 		= 0;
+	proc->blocked_on 	= NULL;
+	proc->locks_held 	= 0;
+	proc->inherited 	= 0;
+	proc->next 				= NULL;
+}
+
+#define owner(l) ((process_t *) ((l)->held & ~1))
+
+int main(void) {
+	lock_t l;
+	int medium_preempts;
+
+	procs = mmap(NULL, NPROCS * sizeof(process_t), PROT_READ | PROT_WRITE,
+	             MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+	if (procs == MAP_FAILED) {
+		printf("FAIL: no memory below 2 GB\n");
+		return 1;
+	}
+	init_proc(LOW, 20);
+	init_proc(MEDIUM, 10);
+	init_proc(HIGH, 0);
+	l_init(&l);
+
+	// low runs alone and takes the lock.
+	current_process = &procs[LOW];
+	l_lock(&l);
+	CHECK(owner(&l) == &procs[LOW]);
+
+	// high is released and preempts low, then blocks on the lock.
+	sched_policy.enqueue(&procs[LOW]);
+	current_process = &procs[HIGH];
+	l_lock(&l);
+	CHECK(switches == 1);
+	CHECK(procs[HIGH].blocked && procs[HIGH].blocked_on == &l);
+	CHECK(procs[LOW].prio == (LOCK_PRIO_INHERIT ? 0 : 20));
+	CHECK(procs[LOW].inherited == LOCK_PRIO_INHERIT);
+
+	// low is the only ready process.
+	current_process = sched_policy.dequeue_next();
+	CHECK(current_process == &procs[LOW]);
+
+	// medium is released while low holds the lock.
+	sched_policy.enqueue(&procs[MEDIUM]);
+	medium_preempts = sched_policy.precedes(&procs[MEDIUM], current_process);
+	CHECK(medium_preempts == !LOCK_PRIO_INHERIT);
+	if (medium_preempts) {
+		// The inversion: medium runs to completion while high waits.
+		sched_policy.enqueue(current_process);
+		CHECK(sched_policy.dequeue_next() == &procs[MEDIUM]);
+		current_process = sched_policy.dequeue_next();
+		CHECK(current_process == &procs[LOW]);
+	}
+
+	// low unlocks: high owns the lock and runs next, before medium.
+	l_unlock(&l);
+	CHECK(owner(&l) == &procs[HIGH]);
+	CHECK(!procs[HIGH].blocked && procs[HIGH].locks_held == 1);
+	CHECK(procs[LOW].prio == 20 && !procs[LOW].inherited);
+	CHECK(procs[LOW].locks_held == 0);
+	CHECK(switches == 2);
+	CHECK(sched_policy.dequeue_next() == &procs[HIGH]);
+
+	if (errors) {
+		printf("FAIL: %d check(s)\n", errors);
+		return 1;
+	}
+	printf("ok: medium %s low\n", medium_preempts ? "preempted" : "did not preempt");
+	return 0;
+}
@@ -0,0 +1,139 @@
+/*************************************************************************
+ * rt_heap test
+ *
+ *   Checks the heap against the sorted list it replaced: random task
+ *   sets are pushed, popped and removed in random order on both, and
+ *   every pop must return the same process. Deadlines are drawn from a
+ *   small range so that ties (which both must pop in FIFO order) are
+ *   common.
+ *
+ ************************************************************************/
+
+#include <stdio.h>
+#include "shared_structs.h"
+#include "rt_heap.h"
+
+#define ROUNDS 	2000
+#define OPS 		200
+
+process_t procs[RT_HEAP_CAPACITY];
+
+/*------------------------------------------------*/
+/* Reference: the EDF list from the original tree */
+/*------------------------------------------------*/
+process_t * rt_queue = NULL;
+
+// Push the process onto the rt_queue: order by EDF.
+void push_onto_rt_queue(process_t *proc) {
+	//If there is nothing in rt_queue, make proc head of queue
+	if (!rt_queue) {
+		rt_queue = proc;
+		proc->next = NULL;
+		return;
+	}
+
+	//Check if earliest deadline. If so, put in front
+	process_t * temp = rt_queue;
+	if (temp->deadline > proc->deadline) {
+		proc->next = temp;
+		rt_queue = proc;
+		return;
+	}
+
+	//Otherwise, iterate through queue until bigger deadline is found.
+	//Insert in front of bigger deadline.
+	process_t * tail = NULL;
+	process_t * itr = temp;
+
+	while ((itr != NULL) && (itr->deadline <= proc->deadline)) {
+		tail = itr;
+		itr = itr->next;
+	}
+
+	proc->next = itr;
+	tail->next = proc;
+}
+
+// Every job in the test is released, so this is the head of the list.
+process_t * pop_rt_process(void) {
+	process_t *proc = rt_queue;
+	if (proc) {
+		rt_queue 		= proc->next;
+		proc->next 	= NULL;
+	}
+	return proc;
+}
+
+void remove_rt_process(process_t *proc) {
+	process_t **itr = &rt_queue;
+	while (*itr && *itr != proc) itr = &(*itr)->next;
+	if (*itr) *itr = proc->next;
+	proc->next = NULL;
+}
+
+/*------------------*/
+/* Helper functions */
+/*------------------*/
+unsigned int seed = 1;
+unsigned int next_random(void) {
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+int main(void) {
+	static int queued[RT_HEAP_CAPACITY];
+	rt_heap_t heap;
+	int round, op, i;
+	int errors = 0;
+	int pops = 0;
+
+	for (round = 0; round < ROUNDS && !errors; round++) {
+		unsigned int range = 1 + next_random() % 50;
+
+		rt_heap_init(&heap);
+		rt_queue = NULL;
+		for (i = 0; i < RT_HEAP_CAPACITY; i++) queued[i] = 0;
+
+		for (op = 0; op < OPS && !errors; op++) {
+			unsigned int r = next_random() % 10;
+			i = next_random() % RT_HEAP_CAPACITY;
+
+			if (r < 5) {
+				// Push a job that is not queued yet.
+				if (queued[i]) continue;
+				procs[i].deadline = next_random() % range;
+				push_onto_rt_queue(&procs[i]);
+				if (rt_heap_push(&heap, procs[i].deadline, &procs[i]) != 0) errors++;
+				queued[i] = 1;
+			} else if (r < 9) {
+				process_t *expect = rt_queue;
+				if (rt_heap_peek(&heap) != expect) errors++;
+				if (expect && rt_heap_peek_key(&heap) != expect->deadline) errors++;
+				expect = pop_rt_process();
+				if (rt_heap_pop(&heap) != expect) errors++;
+				if (expect) queued[expect - procs] = 0;
+				pops++;
+			} else {
+				// Remove a job, queued or not.
+				if (rt_heap_remove(&heap, &procs[i]) != (queued[i] ? 0 : -1)) errors++;
+				if (queued[i]) remove_rt_process(&procs[i]);
+				queued[i] = 0;
+			}
+		}
+
+		// Drain both.
+		while (rt_queue && !errors) {
+			process_t *expect = pop_rt_process();
+			if (rt_heap_pop(&heap) != expect) errors++;
+			pops++;
+		}
+		if (heap.size != 0) errors++;
+	}
+
+	if (errors) {
+		printf("FAIL: heap and list disagree in round %d\n", round - 1);
+		return 1;
+	}
+	printf("ok: %d rounds, %d pops\n", ROUNDS, pops);
+	return 0;
+}
@@ -0,0 +1,347 @@
+/*************************************************************************
+ * Scheduling policy test
+ *
+ *   Built once per policy (-DSCHED_POLICY=...), which compiles the
+ *   other policies out. Checks the order in which enqueued
+ *   processes come back out of dequeue_next, remove, precedes and ready,
+ *   and the preemption decisions of on_tick. The kernel side the
+ *   policies rely on (the process_queue FIFO, the clock and the policy
+ *   timers) is stubbed below; time only moves when a test says so.
+ *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "shared_structs.h"
+#include "sched.h"
+
+process_t * current_process 	= NULL;
+process_t * process_queue 		= NULL;
+process_t * process_tail 			= NULL;
+
+int errors = 0;
+
+#define CHECK(cond) do { 																\
+	if (!(cond)) { 																				\
+		printf("%s:%d: FAIL: %s\n", __FILE__, __LINE__, #cond); 	\
+		errors++; 																					\
+	} 																										\
+} while (0)
+
+/*-----------------------------*/
+/* Kernel stubs: the FIFO      */
+/*-----------------------------*/
+void push_tail_process(process_t *proc) {
+	if (!process_queue) process_queue = proc;
+	if (process_tail) process_tail->next = proc;
+	process_tail = proc;
+	proc->next = NULL;
+}
+
+process_t * pop_front_process(void) {
+	process_t *proc = process_queue;
+	if (!proc) return NULL;
+	process_queue = proc->next;
+	if (process_tail == proc) process_tail = NULL;
+	proc->next = NULL;
+	return proc;
+}
+
+void remove_process(process_t *proc) {
+	process_t **itr = &process_queue;
+	process_t *prev = NULL;
+	while (*itr && *itr != proc) {
+		prev = *itr;
+		itr  = &(*itr)->next;
+	}
+	if (!*itr) return;
+	*itr = proc->next;
+	if (process_tail == proc) process_tail = prev;
+	proc->next = NULL;
+}
+
+/*-----------------------------------------------*/
+/* Kernel stubs: a clock that counts us directly */
+/*-----------------------------------------------*/
+systime_t now = 0;
+
+systime_t process_time(void) { return now; }
+uint64_t clock_cycles(void) { return now; }
+systime_t cycles_to_systime(uint64_t cycles) { return cycles; }
+uint64_t systime_to_cycles(systime_t time) { return time; }
+
+// Last policy timer armed, and whether it is still pending.
+systime_t timer_when;
+int timer_pending = 0;
+
+void process_timer_add(timer_node_t *t, systime_t when) {
+	timer_when 		= when;
+	timer_pending = 1;
+}
+
+void process_timer_cancel(timer_node_t *t) {
+	timer_pending = 0;
+}
+
+/*------------------*/
+/* Helper functions */
+/*------------------*/
+process_t procs[8];
+
+process_t * task(int i, int rt, systime_t start, systime_t deadline, systime_t period, int prio) {
+	process_t *proc = &procs[i];
+	memset(proc, 0, sizeof(*proc));
+	proc->rt 				= rt;
+	proc->start 		= start;
+	proc->deadline 	= deadline;
+	proc->period 		= period;
+	proc->prio 			= prio;
+	return proc;
+}
+
+// Dequeue everything, and check it comes out as procs[order[0]], ...
+void expect_order(const int *order, int n) {
+	int i;
+	for (i = 0; i < n; i++) {
+		process_t *proc = sched_policy.dequeue_next();
+		if (proc != &procs[order[i]]) {
+			printf("FAIL: dequeue %d: expected procs[%d], got %s%d\n", i, order[i],
+			       proc ? "procs[" : "NULL ", proc ? (int) (proc - procs) : 0);
+			errors++;
+			return;
+		}
+	}
+	CHECK(sched_policy.dequeue_next() == NULL);
+	if (sched_policy.ready) CHECK(!sched_policy.ready());
+}
+
+#if SCHED_POLICY == SCHED_EDF
+/*-----*/
+/* EDF */
+/*-----*/
+void test_policy(void) {
+	// Earliest deadline first, FIFO among equal deadlines, then the
+	// non-real-time processes in FIFO order.
+	sched_policy.enqueue(task(0, 0, 0, 0, 0, 0));
+	sched_policy.enqueue(task(1, 1, 0, 300, 0, 0));
+	sched_policy.enqueue(task(2, 1, 0, 100, 0, 0));
+	sched_policy.enqueue(task(3, 0, 0, 0, 0, 0));
+	sched_policy.enqueue(task(4, 1, 0, 200, 0, 0));
+	sched_policy.enqueue(task(5, 1, 0, 100, 0, 0));
+	CHECK(sched_policy.ready());
+#if CBS_ENABLE
+	// The server (deadline now + period) is later than every job here.
+	CHECK(cbs_server.deadline == now + CBS_PERIOD_MS * 1000);
+#endif
+	{
+		const int order[] = {2, 5, 4, 1, 0, 3};
+		expect_order(order, 6);
+	}
+
+	// remove
+	sched_policy.enqueue(task(0, 1, 0, 100, 0, 0));
+	sched_policy.enqueue(task(1, 1, 0, 200, 0, 0));
+	sched_policy.enqueue(task(2, 0, 0, 0, 0, 0));
+	sched_policy.enqueue(task(3, 0, 0, 0, 0, 0));
+	sched_policy.remove(&procs[0]);
+	sched_policy.remove(&procs[3]);
+	{
+		const int order[] = {1, 2};
+		expect_order(order, 2);
+	}
+
+	// precedes
+	CHECK(sched_policy.precedes(task(0, 1, 0, 100, 0, 0), task(1, 1, 0, 200, 0, 0)));
+	CHECK(!sched_policy.precedes(&procs[1], &procs[0]));
+	CHECK(!sched_policy.precedes(&procs[0], task(2, 1, 0, 100, 0, 0)));
+	CHECK(sched_policy.precedes(&procs[0], task(3, 0, 0, 0, 0, 0)));
+	CHECK(!sched_policy.precedes(&procs[3], &procs[0]));
+
+	// on_tick: preempt for an earlier deadline, or any job over a
+	// non-real-time process; not for an equal or later deadline.
+	CHECK(!sched_policy.on_tick(task(6, 1, 0, 150, 0, 0)));
+	sched_policy.enqueue(task(0, 1, 0, 150, 0, 0));
+	CHECK(!sched_policy.on_tick(&procs[6]));
+	CHECK(sched_policy.on_tick(task(7, 1, 0, 151, 0, 0)));
+	CHECK(!sched_policy.on_tick(task(7, 1, 0, 149, 0, 0)));
+	CHECK(sched_policy.on_tick(task(7, 0, 0, 0, 0, 0)));
+	sched_policy.dequeue_next();
+}
+
+#if CBS_ENABLE
+void test_cbs(void) {
+	process_t *proc;
+
+	// A fresh server: deadline now + period, full budget.
+	now = 1000000;
+	sched_policy.enqueue(task(0, 0, 0, 0, 0, 0));
+	CHECK(cbs_server.deadline == now + CBS_PERIOD_MS * 1000);
+	CHECK(cbs_server.remaining == CBS_BUDGET_MS * 1000);
+
+	// A job due after the server loses to the non-real-time process,
+	// which is then charged against a budget timer.
+	sched_policy.enqueue(task(1, 1, 0, now + 2 * CBS_PERIOD_MS * 1000 - 1, 0, 0));
+	proc = sched_policy.dequeue_next();
+	CHECK(proc == &procs[0]);
+	CHECK(timer_pending && timer_when == now + CBS_BUDGET_MS * 1000);
+
+	// Half the budget: no preemption yet.
+	now += CBS_BUDGET_MS * 500;
+	CHECK(!sched_policy.on_tick(proc));
+	CHECK(cbs_server.remaining == CBS_BUDGET_MS * 500);
+	CHECK(timer_pending && timer_when == now + CBS_BUDGET_MS * 500);
+
+	// Budget used up: recharged, deadline one period later, which is now
+	// after the job's, so the job preempts.
+	now += CBS_BUDGET_MS * 500;
+	CHECK(sched_policy.on_tick(proc));
+	CHECK(cbs_server.remaining == CBS_BUDGET_MS * 1000);
+	CHECK(cbs_server.deadline == 1000000 + 2 * CBS_PERIOD_MS * 1000);
+	CHECK(cbs_server.replenished == 1);
+	CHECK(cbs_server.delivered == CBS_BUDGET_MS * 1000);
+
+	sched_policy.enqueue(proc);
+	CHECK(sched_policy.dequeue_next() == &procs[1]);
+	CHECK(!timer_pending);
+	CHECK(sched_policy.dequeue_next() == &procs[0]);
+	CHECK(sched_policy.dequeue_next() == NULL);
+	CHECK(cbs_server.idle);
+
+	// A non-real-time process wakes the idle server while a job runs. A
+	// fresh server deadline after the job's: no preemption.
+	now = cbs_server.deadline;
+	current_process = task(1, 1, 0, now + CBS_PERIOD_MS * 500, 0, 0);
+	SCB->ICSR = 0;
+	sched_policy.enqueue(task(0, 0, 0, 0, 0, 0));
+	CHECK(!(SCB->ICSR & SCB_ICSR_PENDSVSET_Msk));
+	CHECK(!sched_policy.on_tick(current_process));
+	CHECK(sched_policy.dequeue_next() == &procs[0]);
+	CHECK(sched_policy.dequeue_next() == NULL);
+
+	// Before the job's: the server preempts it right away, and on_tick
+	// agrees.
+	now = cbs_server.deadline;
+	current_process->deadline = now + 2 * CBS_PERIOD_MS * 1000;
+	sched_policy.enqueue(task(0, 0, 0, 0, 0, 0));
+	CHECK(SCB->ICSR & SCB_ICSR_PENDSVSET_Msk);
+	CHECK(sched_policy.on_tick(current_process));
+	CHECK(sched_policy.dequeue_next() == &procs[0]);
+	CHECK(sched_policy.dequeue_next() == NULL);
+	current_process = NULL;
+}
+#endif
+
+#elif SCHED_POLICY == SCHED_RM
+/*----*/
+/* RM */
+/*----*/
+void test_policy(void) {
+	// Shortest period first; one-shot jobs by relative deadline; FIFO
+	// among equals; then the non-real-time processes.
+	sched_policy.enqueue(task(0, 0, 0, 0, 0, 0));
+	sched_policy.enqueue(task(1, 1, 0, 900, 500, 0));
+	sched_policy.enqueue(task(2, 1, 0, 100, 300, 0));
+	sched_policy.enqueue(task(3, 1, 1000, 1400, 0, 0));
+	sched_policy.enqueue(task(4, 1, 0, 50, 300, 0));
+	{
+		const int order[] = {2, 4, 3, 1, 0};
+		expect_order(order, 5);
+	}
+
+	// remove
+	sched_policy.enqueue(task(0, 1, 0, 100, 100, 0));
+	sched_policy.enqueue(task(1, 1, 0, 200, 200, 0));
+	sched_policy.enqueue(task(2, 0, 0, 0, 0, 0));
+	sched_policy.remove(&procs[1]);
+	sched_policy.remove(&procs[2]);
+	{
+		const int order[] = {0};
+		expect_order(order, 1);
+	}
+
+	// on_tick: preempt for a strictly shorter period, or any job over a
+	// non-real-time process.
+	CHECK(!sched_policy.on_tick(task(6, 1, 0, 0, 200, 0)));
+	sched_policy.enqueue(task(0, 1, 0, 1000, 200, 0));
+	CHECK(!sched_policy.on_tick(&procs[6]));
+	CHECK(sched_policy.on_tick(task(7, 1, 0, 0, 201, 0)));
+	CHECK(!sched_policy.on_tick(task(7, 1, 0, 0, 199, 0)));
+	CHECK(sched_policy.on_tick(task(7, 0, 0, 0, 0, 0)));
+	sched_policy.dequeue_next();
+}
+
+#elif SCHED_POLICY == SCHED_FP
+/*----------------*/
+/* Fixed priority */
+/*----------------*/
+void test_policy(void) {
+	// Highest priority (lowest value) first, FIFO within a level; rt
+	// makes no difference.
+	sched_policy.enqueue(task(0, 0, 0, 0, 0, SCHED_PRIO_LOWEST));
+	sched_policy.enqueue(task(1, 0, 0, 0, 0, 5));
+	sched_policy.enqueue(task(2, 1, 0, 10, 0, 5));
+	sched_policy.enqueue(task(3, 0, 0, 0, 0, SCHED_PRIO_HIGHEST));
+	sched_policy.enqueue(task(4, 0, 0, 0, 0, 7));
+	sched_policy.enqueue(task(5, 0, 0, 0, 0, 5));
+	{
+		const int order[] = {3, 1, 2, 5, 4, 0};
+		expect_order(order, 6);
+	}
+
+	// remove, including the last process of a level
+	sched_policy.enqueue(task(0, 0, 0, 0, 0, 3));
+	sched_policy.enqueue(task(1, 0, 0, 0, 0, 3));
+	sched_policy.enqueue(task(2, 0, 0, 0, 0, 3));
+	sched_policy.enqueue(task(3, 0, 0, 0, 0, 1));
+	sched_policy.remove(&procs[2]);
+	sched_policy.remove(&procs[3]);
+	sched_policy.enqueue(task(4, 0, 0, 0, 0, 3));
+	{
+		const int order[] = {0, 1, 4};
+		expect_order(order, 3);
+	}
+
+	// on_tick: preempt only for a strictly higher priority.
+	CHECK(!sched_policy.on_tick(task(6, 0, 0, 0, 0, 4)));
+	sched_policy.enqueue(task(0, 0, 0, 0, 0, 4));
+	CHECK(!sched_policy.on_tick(&procs[6]));
+	CHECK(sched_policy.on_tick(task(7, 0, 0, 0, 0, 5)));
+	CHECK(!sched_policy.on_tick(task(7, 0, 0, 0, 0, 3)));
+	CHECK(sched_policy.precedes(&procs[6], &procs[7]) == 0);
+	CHECK(sched_policy.precedes(&procs[7], &procs[6]));
+	sched_policy.dequeue_next();
+}
+
+#elif SCHED_POLICY == SCHED_RR
+/*-------------*/
+/* Round-robin */
+/*-------------*/
+void test_policy(void) {
+	// Plain FIFO, deadlines ignored, never preempts early.
+	sched_policy.enqueue(task(0, 1, 0, 500, 0, 0));
+	sched_policy.enqueue(task(1, 0, 0, 0, 0, 0));
+	sched_policy.enqueue(task(2, 1, 0, 100, 0, 0));
+	sched_policy.enqueue(task(3, 0, 0, 0, 0, 0));
+	sched_policy.remove(&procs[1]);
+	{
+		const int order[] = {0, 2, 3};
+		expect_order(order, 3);
+	}
+	CHECK(sched_policy.on_tick == NULL);
+	CHECK(!sched_policy.precedes(&procs[2], &procs[0]));
+	CHECK(!sched_policy.precedes(&procs[0], &procs[2]));
+}
+#endif
+
+int main(void) {
+	test_policy();
+#if SCHED_POLICY == SCHED_EDF && CBS_ENABLE
+	test_cbs();
+#endif
+	if (errors) {
+		printf("FAIL: %d check(s)\n", errors);
+		return 1;
+	}
+	printf("ok\n");
+	return 0;
+}
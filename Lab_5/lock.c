@@ -0,0 +1,228 @@
+#include "lock.h"
+#include "sched.h"
+
+/*
+  lock_t.held is 0 when the lock is free. Otherwise it holds the owner's
+  process_t pointer, with LOCK_WAITERS set while processes are parked
+  on blocked_queue.
+	
+  The uncontended cases (free -> owned and owned -> free) are a single
+  LDREX/STREX pair with no SVC and no interrupt masking. Any exception
+  clears the exclusive monitor, so a STREX interrupted by a context
+  switch simply fails and retries. Everything involving blocked_queue
+  runs with interrupts disabled.
+	
+  Priority inheritance: a process that blocks on a lock lends its
+  scheduling parameters to the owner (and to whoever the owner is
+  itself blocked on) when the policy says it must run first. The owner
+  gets its own parameters back once it holds no more locks.
+ */
+#define LOCK_FREE 		0
+#define LOCK_WAITERS 	1
+
+#define lock_owner(l) ((process_t *) ((l)->held & ~LOCK_WAITERS))
+
+//-------------------------------------------------------------------
+// l_init -----------------------------------------------------------
+//-------------------------------------------------------------------
+void l_init(lock_t *l) {
+	l->held 							= LOCK_FREE;
+	l->blocked_queue 			= NULL;
+	l->blocked_queue_end 	= NULL;
+}
+
+//-------------------------------------------------------------------
+// try_transition ---------------------------------------------------
+//-------------------------------------------------------------------
+// Atomically changes l->held from "from" to "to". Returns 0 if it was not "from".
+static int try_transition(lock_t *l, uint32_t from, uint32_t to) {
+	volatile uint32_t *word = (volatile uint32_t *) &l->held;
+
+	do {
+		if (__LDREXW(word) != from) {
+			__CLREX();
+			return 0;
+		}
+	} while (__STREXW(to, word));
+	return 1;
+}
+
+//-------------------------------------------------------------------
+// inherit ----------------------------------------------------------
+//-------------------------------------------------------------------
+// Lends the scheduling parameters of waiter to owner, and on along the
+// chain of locks owner is blocked on, as long as waiter must run first.
+static void inherit(process_t *owner, process_t *waiter) {
+	while (owner && sched_policy.precedes(waiter, owner)) {
+		// A ready owner sits in the policy's queues under its old
+		// parameters: take it out while they change.
+		int ready = !owner->blocked && (owner != current_process);
+		if (ready) sched_policy.remove(owner);
+
+		if (!owner->inherited) {
+			owner->base.rt 				= owner->rt;
+			owner->base.start 		= owner->start;
+			owner->base.deadline 	= owner->deadline;
+			owner->base.period 		= owner->period;
+			owner->base.prio 			= owner->prio;
+			owner->inherited 			= 1;
+		}
+		owner->rt 				= waiter->rt;
+		owner->start 			= waiter->start;
+		owner->deadline 	= waiter->deadline;
+		owner->period 		= waiter->period;
+		owner->prio 			= waiter->prio;
+
+		if (ready) sched_policy.enqueue(owner);
+
+		owner = owner->blocked_on ? lock_owner(owner->blocked_on) : NULL;
+	}
+}
+
+//-------------------------------------------------------------------
+// lock_disinherit --------------------------------------------------
+//-------------------------------------------------------------------
+void lock_disinherit(process_t *proc) {
+	proc->rt 				= proc->base.rt;
+	proc->start 		= proc->base.start;
+	proc->deadline 	= proc->base.deadline;
+	proc->period 		= proc->base.period;
+	proc->prio 			= proc->base.prio;
+	proc->inherited = 0;
+}
+
+//-------------------------------------------------------------------
+// release ----------------------------------------------------------
+//-------------------------------------------------------------------
+// Releases l, held by the running process, handing it to the first
+// waiter if there is one. Must be called with interrupts disabled.
+// Returns the new owner, or NULL if the lock is now free.
+static process_t * release(lock_t *l) {
+	process_t *next = unpark_process(&l->blocked_queue, &l->blocked_queue_end);
+	if (!next) {
+		l->held = LOCK_FREE;
+	} else {
+		l->held = (int) next | (l->blocked_queue ? LOCK_WAITERS : 0);
+		next->locks_held++;
+	}
+
+	if (--current_process->locks_held == 0 && current_process->inherited) {
+		lock_disinherit(current_process);
+	}
+	return next;
+}
+
+//-------------------------------------------------------------------
+// l_lock -----------------------------------------------------------
+//-------------------------------------------------------------------
+void l_lock(lock_t *l) {
+	if (try_transition(l, LOCK_FREE, (uint32_t) current_process)) {
+		current_process->locks_held++;
+		__DMB();
+		return;
+	}
+
+	// Slow path: the lock is held.
+	__disable_irq();
+	if (l->held == LOCK_FREE) {
+		// Released since the fast path looked.
+		l->held = (int) current_process;
+		current_process->locks_held++;
+		__enable_irq();
+		__DMB();
+		return;
+	}
+
+	// Park on blocked_queue, behind every waiter that must run before
+	// this process. l_unlock hands the lock over and makes this process
+	// ready again, so it owns the lock when process_blocked returns.
+	l->held |= LOCK_WAITERS;
+	current_process->blocked 		= 1;
+	current_process->blocked_on = l;
+
+	park_process(&l->blocked_queue, &l->blocked_queue_end, current_process);
+
+#if LOCK_PRIO_INHERIT
+	inherit(lock_owner(l), current_process);
+#endif
+
+	process_blocked();	// re-enables interrupts
+	__DMB();
+}
+
+//-------------------------------------------------------------------
+// l_unlock ---------------------------------------------------------
+//-------------------------------------------------------------------
+void l_unlock(lock_t *l) {
+	__DMB();
+	if (try_transition(l, (uint32_t) current_process, LOCK_FREE)) {
+		if (--current_process->locks_held == 0 && current_process->inherited) {
+			__disable_irq();
+			lock_disinherit(current_process);
+			__enable_irq();
+		}
+		return;
+	}
+
+	// Slow path: somebody is waiting. Hand the lock to the first waiter.
+	__disable_irq();
+	process_t *next = release(l);
+
+	// Let the new owner run right away if it must run first.
+	if (next && sched_policy.precedes(next, current_process)) {
+		process_blocked();	// re-enables interrupts
+	} else {
+		__enable_irq();
+	}
+}
+
+//-------------------------------------------------------------------
+// c_init -----------------------------------------------------------
+//-------------------------------------------------------------------
+void c_init(lock_t *l, cond_t *c) {
+	c->waiting 			= NULL;
+	c->waiting_end 	= NULL;
+}
+
+//-------------------------------------------------------------------
+// c_wait -----------------------------------------------------------
+//-------------------------------------------------------------------
+void c_wait(lock_t *l, cond_t *c) {
+	// Parking on c and releasing l happen with interrupts disabled, up
+	// to the switch: a c_signal cannot slip in between and be lost.
+	__DMB();
+	__disable_irq();
+	release(l);
+	current_process->blocked = 1;
+	park_process(&c->waiting, &c->waiting_end, current_process);
+	process_blocked();	// re-enables interrupts
+
+	l_lock(l);
+}
+
+//-------------------------------------------------------------------
+// c_waiting --------------------------------------------------------
+//-------------------------------------------------------------------
+int c_waiting(lock_t *l, cond_t *c) {
+	return c->waiting != NULL;
+}
+
+//-------------------------------------------------------------------
+// c_signal ---------------------------------------------------------
+//-------------------------------------------------------------------
+void c_signal(lock_t *l, cond_t *c) {
+	uint32_t m = __get_PRIMASK();
+	__disable_irq();
+	unpark_process(&c->waiting, &c->waiting_end);
+	__set_PRIMASK(m);
+}
+
+//-------------------------------------------------------------------
+// c_broadcast ------------------------------------------------------
+//-------------------------------------------------------------------
+void c_broadcast(lock_t *l, cond_t *c) {
+	uint32_t m = __get_PRIMASK();
+	__disable_irq();
+	while (unpark_process(&c->waiting, &c->waiting_end));
+	__set_PRIMASK(m);
+}
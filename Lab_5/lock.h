@@ -0,0 +1,52 @@
+/*************************************************************************
+ *
+ *  Locks and condition variables for processes created with process_create / process_rt_create.
+ *
+ **************************************************************************
+ */
+#ifndef __LOCK_H__
+#define __LOCK_H__
+
+#include "shared_structs.h"
+
+/* Set to 0 to build locks without priority inheritance. */
+#ifndef LOCK_PRIO_INHERIT
+#define LOCK_PRIO_INHERIT 1
+#endif
+
+/* Initialize a lock. Must be called before the lock is used. */
+void l_init(lock_t *l);
+
+/* Acquire the lock, blocking the calling process until it is available.
+   While it waits, the owner inherits its scheduling parameters if the
+   policy would run the caller first. Must be called from a process, with
+   interrupts enabled. */
+void l_lock(lock_t *l);
+
+/* Release a lock held by the calling process. If processes are waiting,
+   ownership passes directly to the one that must run first. The caller
+   loses any inherited parameters once it holds no more locks. */
+void l_unlock(lock_t *l);
+
+/* Initialize a condition variable used with the lock l. Must be called
+   before the condition variable is used. */
+void c_init(lock_t *l, cond_t *c);
+
+/* Release l and block until c is signalled, then take l again before
+   returning. Releasing l and parking on c are atomic, so a c_signal
+   issued after the caller released l is never lost. Wake-ups may be
+   spurious: always call c_wait in a loop that rechecks the condition.
+   Must be called from a process holding l. */
+void c_wait(lock_t *l, cond_t *c);
+
+/* Return non-zero if processes are waiting on c. */
+int c_waiting(lock_t *l, cond_t *c);
+
+/* Wake the waiter on c that must run first (earliest deadline for
+   real-time waiters), if any. Should be called with l held. */
+void c_signal(lock_t *l, cond_t *c);
+
+/* Wake every waiter on c. Should be called with l held. */
+void c_broadcast(lock_t *l, cond_t *c);
+
+#endif
@@ -0,0 +1,144 @@
+#include "msgq.h"
+#include "sched.h"
+
+/*
+  Slots are reserved and received strictly in ring order (tail and head),
+  but committed and released in any order: each slot carries its own
+  state. A slot is only reserved again once it is MSGQ_FREE, so a
+  message that is still being read stalls the senders rather than being
+  overwritten. All state changes are a few stores with interrupts
+  masked; the message itself is never touched.
+ */
+#define MSGQ_FREE 			0
+#define MSGQ_RESERVED 	1
+#define MSGQ_COMMITTED 	2
+#define MSGQ_TAKEN 			3
+
+#define slot_index(q, msg) (((unsigned char *) (msg) - (q)->slots) / (q)->size)
+
+//-------------------------------------------------------------------
+// mq_init ----------------------------------------------------------
+//-------------------------------------------------------------------
+void mq_init(msgq_t *q, void *slots, unsigned char *state, unsigned int size, unsigned int count) {
+	unsigned int i;
+
+	q->slots 					= (unsigned char *) slots;
+	q->state 					= state;
+	q->size 					= size;
+	q->count 					= count;
+	q->tail 					= 0;
+	q->head 					= 0;
+	q->receivers 			= NULL;
+	q->receivers_end 	= NULL;
+	for (i = 0; i < count; i++) {
+		state[i] = MSGQ_FREE;
+	}
+}
+
+//-------------------------------------------------------------------
+// mq_reserve -------------------------------------------------------
+//-------------------------------------------------------------------
+void * mq_reserve(msgq_t *q) {
+	void *msg = NULL;
+
+	uint32_t m = __get_PRIMASK();
+	__disable_irq();
+	if (q->state[q->tail] == MSGQ_FREE) {
+		q->state[q->tail] = MSGQ_RESERVED;
+		msg = q->slots + q->tail * q->size;
+		if (++q->tail == q->count) q->tail = 0;
+	}
+	__set_PRIMASK(m);
+	return msg;
+}
+
+//-------------------------------------------------------------------
+// wake_receiver ----------------------------------------------------
+//-------------------------------------------------------------------
+// Makes the first blocked receiver ready if the head message is
+// committed, and preempts the running process if the receiver must run
+// first. Called with interrupts disabled.
+static void wake_receiver(msgq_t *q) {
+	process_t *proc;
+
+	if (q->state[q->head] != MSGQ_COMMITTED) return;
+	proc = unpark_process(&q->receivers, &q->receivers_end);
+	if (proc && current_process && sched_policy.precedes(proc, current_process)) {
+		// Also works from an interrupt handler: the switch happens once
+		// interrupts are enabled.
+		process_reschedule();
+	}
+}
+
+//-------------------------------------------------------------------
+// mq_commit --------------------------------------------------------
+//-------------------------------------------------------------------
+void mq_commit(msgq_t *q, void *msg) {
+	// The message contents must be visible before the slot is.
+	__DMB();
+	uint32_t m = __get_PRIMASK();
+	__disable_irq();
+	q->state[slot_index(q, msg)] = MSGQ_COMMITTED;
+	wake_receiver(q);
+	__set_PRIMASK(m);
+}
+
+//-------------------------------------------------------------------
+// take -------------------------------------------------------------
+//-------------------------------------------------------------------
+// Takes the head message if it is committed. Called with interrupts
+// disabled. Returns NULL if there is none.
+static void * take(msgq_t *q) {
+	void *msg;
+
+	if (q->state[q->head] != MSGQ_COMMITTED) return NULL;
+	q->state[q->head] = MSGQ_TAKEN;
+	msg = q->slots + q->head * q->size;
+	if (++q->head == q->count) q->head = 0;
+	// More messages may be waiting behind this one for other receivers.
+	wake_receiver(q);
+	return msg;
+}
+
+//-------------------------------------------------------------------
+// mq_try_receive ---------------------------------------------------
+//-------------------------------------------------------------------
+void * mq_try_receive(msgq_t *q) {
+	void *msg;
+
+	uint32_t m = __get_PRIMASK();
+	__disable_irq();
+	msg = take(q);
+	__set_PRIMASK(m);
+	__DMB();
+	return msg;
+}
+
+//-------------------------------------------------------------------
+// mq_receive -------------------------------------------------------
+//-------------------------------------------------------------------
+void * mq_receive(msgq_t *q) {
+	void *msg;
+
+	__disable_irq();
+	// Another receiver may take the message between the wake-up and
+	// this process running: check again every time.
+	while ((msg = take(q)) == NULL) {
+		current_process->blocked = 1;
+		park_process(&q->receivers, &q->receivers_end, current_process);
+		process_blocked();	// re-enables interrupts
+		__disable_irq();
+	}
+	__enable_irq();
+	__DMB();
+	return msg;
+}
+
+//-------------------------------------------------------------------
+// mq_release -------------------------------------------------------
+//-------------------------------------------------------------------
+void mq_release(msgq_t *q, void *msg) {
+	// Done reading before a sender may reuse the slot.
+	__DMB();
+	q->state[slot_index(q, msg)] = MSGQ_FREE;
+}
@@ -0,0 +1,56 @@
+/*************************************************************************
+ *
+ *  Zero-copy message queues between processes.
+ *
+ *  A queue is a ring of count fixed-size slots in memory supplied by the
+ *  caller. A sender reserves a slot, fills it in place and commits it; a
+ *  receiver gets a pointer to the oldest committed slot and releases it
+ *  once done with it. Messages are never copied and nothing is allocated
+ *  after mq_init.
+ *
+ **************************************************************************
+ */
+#ifndef __MSGQ_H__
+#define __MSGQ_H__
+
+#include "shared_structs.h"
+
+typedef struct msgq {
+	unsigned char *slots;	// count slots of size bytes each
+	unsigned char *state;	// per-slot MSGQ_FREE / RESERVED / COMMITTED / TAKEN
+	unsigned int size;
+	unsigned int count;
+	unsigned int tail;	// next slot to reserve
+	unsigned int head;	// next slot to receive
+	process_t * receivers;	// processes blocked in mq_receive
+	process_t * receivers_end;
+} msgq_t;
+
+/* Initialize q over count slots of size bytes each. slots must hold
+   count * size bytes and state count bytes; both must stay valid as long
+   as q is used. Keep size a multiple of 4 (or 8 for doubles) so every
+   slot is aligned. */
+void mq_init(msgq_t *q, void *slots, unsigned char *state, unsigned int size, unsigned int count);
+
+/* Reserve the next slot, to be filled in place and then committed.
+   Returns NULL if the queue is full. Never blocks, so it may also be
+   called from an interrupt handler. */
+void * mq_reserve(msgq_t *q);
+
+/* Publish a slot returned by mq_reserve. Slots may be committed in any
+   order; receivers still get messages in the order they were reserved.
+   Wakes a blocked receiver if one can now proceed. */
+void mq_commit(msgq_t *q, void *msg);
+
+/* Return the oldest message, blocking the calling process until one is
+   committed. The slot belongs to the caller until mq_release. Must be
+   called from a process, with interrupts enabled. */
+void * mq_receive(msgq_t *q);
+
+/* Like mq_receive, but returns NULL instead of blocking. */
+void * mq_try_receive(msgq_t *q);
+
+/* Hand a slot returned by mq_receive back to the senders. */
+void mq_release(msgq_t *q, void *msg);
+
+#endif
@@ -2,6 +2,11 @@
 #include <fsl_device_registers.h>
 #include "realtime.h"
 #include "shared_structs.h"
+#include "rt_heap.h"
+#include "sched.h"
+#include "admission.h"
+#include "srp.h"
+#include "timer.h"
 
 // Initialize global variables
 
@@ -9,26 +14,153 @@ process_t * current_process	 			= NULL;
 process_t * process_tail 					= NULL;
 process_t * process_queue 				= NULL;
 
-process_t * rt_queue = NULL;
-realtime_t current_time = {0, 0};
+// Number of live processes, and how many of them are real-time.
+int process_count = 0;
+int rt_process_count = 0;
+
+// Parameters of the rt processes created with a WCET, used for admission
+// control. rt_task_proc[i] is the process described by rt_tasks[i].
+rt_task_t rt_tasks[RT_HEAP_CAPACITY + 1];
+process_t * rt_task_proc[RT_HEAP_CAPACITY];
+int rt_task_count = 0;
+
+// Every timed wake-up (job releases, periodic re-arming, sleeps), in
+// TICK_HZ ticks since process_start. Each process has one timer node,
+// proc->timer. All zeroes is a valid empty wheel at time 0.
+timer_wheel_t timers;
+
+#define timer_proc(t) ((process_t *) ((char *) (t) - offsetof(process_t, timer)))
+
+// Wheel tick of a time: the first tick at or after it.
+#define to_tick(time) ((unsigned int) (((time) + TICK_US - 1) / TICK_US))
 
 int process_deadline_met = 0;
 int process_deadline_miss = 0;
 
+// Total time (in ms) the CPU spent sleeping in process_idle().
+unsigned int process_idle_time = 0;
+static uint64_t process_idle_cycles = 0;
+
+// Event timer interrupts, and core cycles spent handling them.
+unsigned int timer_irq_count 	= 0;
+unsigned int timer_irq_cycles = 0;
+unsigned int timer_irq_latency_max = 0;
+
+// Set by process_start once the PIT may be programmed.
+static int timer_started = 0;
+
+// Whether PIT1 is counting down to an event, and the time it is set for.
+static int timer_armed = 0;
+static systime_t timer_armed_at;
+static uint64_t timer_armed_cycles;
+
+// Set while PIT1_IRQHandler advances the wheel and runs its callbacks.
+static int timer_advancing = 0;
+
+// Whether PIT0 expiries are ignored because only one process is runnable.
+static int quantum_stopped = 0;
+
+// Default PIT0 quantum, in clock cycles, and the quantum PIT0 is set for
+// (us, 0 for the default).
+#define QUANTUM_CYCLES (DEFAULT_SYSTEM_CLOCK / 10)
+static systime_t quantum_loaded = 0;
+
+// Release-to-dispatch latency of real-time jobs, in core cycles (DWT CYCCNT).
+unsigned int rt_dispatch_latency_max 		= 0;
+unsigned int rt_dispatch_latency_total 	= 0;
+unsigned int rt_dispatch_count 					= 0;
+
+
+//-------------------------------------------------------------------
+// timer_rearm ------------------------------------------------------
+//-------------------------------------------------------------------
+// Programs PIT1 as a one-shot for the first pending timer, or stops it
+// if there is none. The wheel counts ticks in 32 bits: fine as long as
+// no timer is armed more than 2^31 ticks ahead.
+static void timer_rearm(void) {
+	unsigned int next;
+	uint64_t now, at;
+	systime_t tick;
+
+	PIT->CHANNEL[1].TCTRL = 0;
+	timer_armed = 0;
+	if (!timer_started || !timer_next(&timers, &next)) return;
+
+	now 	= clock_cycles();
+	tick 	= cycles_to_systime(now) / TICK_US;
+	tick += (int) (next - (unsigned int) tick);
+	timer_armed_at = tick * TICK_US;
+	at = systime_to_cycles(timer_armed_at);
+
+	// Fire on the tick itself, but leave PIT1 at least a few cycles if
+	// it has already passed, and at most a full 32-bit count.
+	if (at < now + 64) at = now + 64;
+	if (at - now > 0xFFFFFFFFu) at = now + 0xFFFFFFFFu;
+
+	PIT->CHANNEL[1].LDVAL = (uint32_t) (at - now) - 1;
+	PIT->CHANNEL[1].TFLG  = PIT_TFLG_TIF_MASK;
+	PIT->CHANNEL[1].TCTRL = PIT_TCTRL_TEN_MASK | PIT_TCTRL_TIE_MASK;
+	timer_armed_cycles 		= at;
+	timer_armed = 1;
+}
+
+//-------------------------------------------------------------------
+// process_timer_add ------------------------------------------------
+//-------------------------------------------------------------------
+void process_timer_add(timer_node_t *t, systime_t when) {
+	// The wheel only moves when PIT1 fires: after a long stretch with
+	// nothing pending, its now is far behind, and t would be placed
+	// against it. Bring it up to date first (callbacks run with the
+	// wheel already current).
+	if (timer_started && !timer_advancing) {
+		timer_advance(&timers, (unsigned int) (process_time() / TICK_US));
+	}
+	timer_add(&timers, t, to_tick(when));
+	// Only reprogram PIT1 if this timer comes first.
+	if (!timer_armed || when < timer_armed_at) {
+		timer_rearm();
+	}
+}
+
+//-------------------------------------------------------------------
+// process_timer_cancel ---------------------------------------------
+//-------------------------------------------------------------------
+// PIT1 is left armed: an event with nothing to fire is harmless.
+void process_timer_cancel(timer_node_t *t) {
+	timer_cancel(&timers, t);
+}
+
 //-------------------------------------------------------------------
 // PIT1_IRQHandler --------------------------------------------------
 //-------------------------------------------------------------------
+// PIT1 is a one-shot event timer: it fires when the first pending timer
+// is due (or a far-away one needs cascading in the wheel), never just
+// to keep time.
 void PIT1_IRQHandler(void) {
-	if(current_time.msec > 999)	{
-		current_time.sec++;
-		current_time.msec = 0;
-	}	else {
-		current_time.msec++;
+	unsigned int start = DWT->CYCCNT;
+	uint64_t late = clock_cycles() - timer_armed_cycles;
+
+	if (timer_armed && late < 0x80000000u && late > timer_irq_latency_max) {
+		timer_irq_latency_max = (unsigned int) late;
 	}
 
-	PIT->CHANNEL[1].TCTRL = 0;
-	PIT->CHANNEL[1].TFLG |= PIT_TFLG_TIF_MASK;
-	PIT->CHANNEL[1].TCTRL = PIT_TCTRL_TEN_MASK| PIT_TCTRL_TIE_MASK;
+	PIT->CHANNEL[1].TFLG = PIT_TFLG_TIF_MASK;
+
+	timer_advancing = 1;
+	timer_advance(&timers, (unsigned int) (process_time() / TICK_US));
+	timer_advancing = 0;
+
+	// If the policy wants the running process preempted (e.g. a job with an
+	// earlier deadline was just released), pend the switch so it happens
+	// as soon as this handler returns instead of at the end of the quantum.
+	if (current_process && sched_policy.on_tick && sched_policy.on_tick(current_process)) {
+		process_reschedule();
+	}
+
+	timer_rearm();
+
+	timer_irq_count++;
+	timer_irq_cycles += DWT->CYCCNT - start;
 }
 
 //-------------------------------------------------------------------
@@ -65,98 +197,271 @@ process_t * pop_front_process() {
 }
 
 //-------------------------------------------------------------------
-// push_onto_rt_queue --------------------------------------------
+// remove_process ---------------------------------------------------
 //-------------------------------------------------------------------
-// Push the process onto the rt_queue: order by EDF.
-void push_onto_rt_queue(process_t *proc) {
-	//If there is nothing in rt_queue, make proc head of queue
-	if (!rt_queue) {
-		rt_queue = proc;
-		return;
-	}
+// Removes proc from anywhere in process_queue, if it is there.
+void remove_process(process_t *proc) {
+	process_t * prev = NULL;
+	process_t * itr  = process_queue;
 
-	//Check if earliest deadline. If so, put in front
-	process_t * temp = rt_queue;
-	if (temp->deadline > proc->deadline) {
-		proc->next = temp;
-		rt_queue = proc;
-		return;
+	while ((itr != NULL) && (itr != proc)) {
+		prev = itr;
+		itr  = itr->next;
 	}
+	if (!itr) return;
 
-	//Otherwise, iterate through queue until bigger deadline is found.
-	//Insert in front of bigger deadline.
-	process_t * tail = NULL;
-	process_t * itr = temp;
-	
-	while ((itr != NULL) && (itr->deadline <= proc->deadline)) {
-		tail = itr;
-		itr = itr->next;
+	if (prev) {
+		prev->next = proc->next;
+	} else {
+		process_queue = proc->next;
+	}
+	if (process_tail == proc) {
+		process_tail = prev;
 	}
+	proc->next = NULL;
+}
 
-	proc->next = itr;
-	tail->next = proc;
+//-------------------------------------------------------------------
+// quantum_stop -----------------------------------------------------
+//-------------------------------------------------------------------
+// Only the running process is runnable: PIT0 expiries would just
+// reselect it, so stop taking them.
+static void quantum_stop(void) {
+	NVIC_DisableIRQ(PIT0_IRQn);
+	quantum_stopped = 1;
 }
 
 //-------------------------------------------------------------------
-// pop_rt_process ---------------------------------------------------
+// quantum_start ----------------------------------------------------
 //-------------------------------------------------------------------
-// Returns a realtime process with earliest deadline out of all the
-// processes that are ready (rt_queue is ordered by EDF).
-process_t * pop_rt_process() {
-	int real_time = 1000 * current_time.sec + current_time.msec;
-	
-	//If rt_queue is empty return NULL
-	if (!rt_queue) return NULL;
-	
-	//Otheriwse, iterate through queue until ready process found.
-	process_t * itr 	= rt_queue;
-	process_t * prev 	= NULL;
-
-	while ( itr != NULL) {
-		//If itr is ready
-		if (itr->start <= real_time) {
-			//Check if itr is the first process in rt_queue; pop accordingly if so.
-			if (itr == rt_queue) {
-				rt_queue 	= itr->next;
-				itr->next = NULL;
-				return itr;
-			} else {
-				prev->next = itr->next;
-				itr->next  = NULL;
-				return itr;		
-			}
-		}
+// Another process is runnable again: give the running one a fresh
+// quantum.
+static void quantum_start(void) {
+	quantum_stopped 			= 0;
+	PIT->CHANNEL[0].TCTRL = 0;
+	PIT->CHANNEL[0].TFLG  = PIT_TFLG_TIF_MASK;
+	PIT->CHANNEL[0].TCTRL = PIT_TCTRL_TEN_MASK | PIT_TCTRL_TIE_MASK;
+	NVIC_ClearPendingIRQ(PIT0_IRQn);
+	NVIC_EnableIRQ(PIT0_IRQn);
+}
+
+//-------------------------------------------------------------------
+// quantum_load -----------------------------------------------------
+//-------------------------------------------------------------------
+// Reprograms PIT0 for a quantum of q us (0 for the default), starting
+// now. Quanta past a full 32-bit count are capped.
+static void quantum_load(systime_t q) {
+	uint64_t cycles = q ? systime_to_cycles(q) : QUANTUM_CYCLES;
+
+	quantum_loaded 				= q;
+	PIT->CHANNEL[0].TCTRL = 0;
+	PIT->CHANNEL[0].LDVAL = cycles > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t) cycles - 1;
+	PIT->CHANNEL[0].TFLG  = PIT_TFLG_TIF_MASK;
+	PIT->CHANNEL[0].TCTRL = PIT_TCTRL_TEN_MASK | PIT_TCTRL_TIE_MASK;
+	NVIC_ClearPendingIRQ(PIT0_IRQn);
+}
+
+//-------------------------------------------------------------------
+// process_ready ----------------------------------------------------
+//-------------------------------------------------------------------
+void process_ready(process_t *proc) {
+	sched_policy.enqueue(proc);
+	if (quantum_stopped) quantum_start();
+}
+
+//-------------------------------------------------------------------
+// process_wake -----------------------------------------------------
+//-------------------------------------------------------------------
+void process_wake(process_t *proc) {
+	proc->blocked = 0;
+	// Blocked, but process_blocked has not switched it out yet (the
+	// waker ran between its CPSIE and PendSV): process_select sees it
+	// is no longer blocked and queues it itself.
+	if (proc != current_process) process_ready(proc);
+}
+
+//-------------------------------------------------------------------
+// park_process -----------------------------------------------------
+//-------------------------------------------------------------------
+// Inserts proc in the wait queue head/tail behind every process that
+// must run before it, so the queue is kept in scheduling order.
+void park_process(process_t **head, process_t **tail, process_t *proc) {
+	process_t * prev = NULL;
+	process_t * itr  = *head;
+	while ((itr != NULL) && !sched_policy.precedes(proc, itr)) {
 		prev = itr;
 		itr  = itr->next;
 	}
-	
-	// Otherwise, no ready process found: return NULL
-	return NULL;
+	proc->next = itr;
+	if (prev) {
+		prev->next = proc;
+	} else {
+		*head = proc;
+	}
+	if (!itr) {
+		*tail = proc;
+	}
+}
+
+//-------------------------------------------------------------------
+// unpark_process ---------------------------------------------------
+//-------------------------------------------------------------------
+// Takes the first process off the wait queue head/tail and makes it
+// ready again. Returns it, or NULL if the queue is empty.
+process_t * unpark_process(process_t **head, process_t **tail) {
+	process_t *proc = *head;
+	if (!proc) return NULL;
+
+	*head = proc->next;
+	if (!*head) *tail = NULL;
+	proc->next 				= NULL;
+	proc->blocked_on 	= NULL;
+	process_wake(proc);
+	return proc;
+}
+
+//-------------------------------------------------------------------
+// release_fire -----------------------------------------------------
+//-------------------------------------------------------------------
+// Timer callback: the start time of a job has come, hand it to the
+// scheduling policy.
+static void release_fire(timer_node_t *t) {
+	process_t *proc = timer_proc(t);
+	proc->released_at = DWT->CYCCNT;
+	proc->released 		= 1;
+	process_ready(proc);
+}
+
+//-------------------------------------------------------------------
+// wake_fire --------------------------------------------------------
+//-------------------------------------------------------------------
+// Timer callback: a sleeping process is due, make it ready again. A
+// short sleep can expire before PendSV switched the sleeper out.
+static void wake_fire(timer_node_t *t) {
+	process_wake(timer_proc(t));
+}
+
+//-------------------------------------------------------------------
+// queue_rt_process -------------------------------------------------
+//-------------------------------------------------------------------
+// Makes a job ready if it has been released by real_time, arms its
+// timer for the start time otherwise.
+void queue_rt_process(process_t *proc, systime_t real_time) {
+	if (proc->start <= real_time) {
+		process_ready(proc);
+		return;
+	}
+	timer_init(&proc->timer, release_fire);
+	process_timer_add(&proc->timer, proc->start);
+}
+
+//-------------------------------------------------------------------
+// admission_test ---------------------------------------------------
+//-------------------------------------------------------------------
+// Runs the schedulability test that matches the scheduling policy on
+// the first n entries of rt_tasks. Returns 1 if they are schedulable.
+int admission_test(int n) {
+#if SCHED_POLICY == SCHED_EDF
+#if CBS_ENABLE
+	// The non-real-time server takes its share of the processor too.
+	rt_tasks[n].wcet 			= cbs_server.budget;
+	rt_tasks[n].deadline 	= cbs_server.period;
+	rt_tasks[n].period 		= cbs_server.period;
+	n++;
+#endif
+	return admission_edf(rt_tasks, n);
+#elif (SCHED_POLICY == SCHED_RM) || (SCHED_POLICY == SCHED_FP)
+	return admission_fp(rt_tasks, n);
+#else
+	// Round-robin gives no guarantees; only reject plain overload.
+	// wcet is in us: shift it in 64 bits.
+	unsigned long long u = 0;
+	int i;
+	for (i = 0; i < n; i++) {
+		if (rt_tasks[i].period) u += ((unsigned long long)rt_tasks[i].wcet << 16) / rt_tasks[i].period;
+	}
+	return u <= (1ull << 16);
+#endif
+}
+
+//-------------------------------------------------------------------
+// release_task -----------------------------------------------------
+//-------------------------------------------------------------------
+// Drops proc's entry from rt_tasks, if it has one.
+void release_task(process_t *proc) {
+	int i = proc->task;
+	if (i < 0) return;
+
+	rt_task_count--;
+	rt_tasks[i] 		= rt_tasks[rt_task_count];
+	rt_task_proc[i] = rt_task_proc[rt_task_count];
+	rt_task_proc[i]->task = i;
+	proc->task = -1;
 }
 
 //-------------------------------------------------------------------
 // process_free -----------------------------------------------------
 //-------------------------------------------------------------------
 void process_free(process_t *proc) {
-	process_stack_free(proc->orig_sp, proc->n);
+	process_count--;
+	if (proc->rt == 1) rt_process_count--;
+	release_task(proc);
+	// SRP jobs run on the shared stack and have none of their own.
+	if (proc->orig_sp) process_stack_free(proc->orig_sp, proc->n);
 	free(proc);
 }
 
 //-------------------------------------------------------------------
-// get_next_start_time ----------------------------------------------
+// dequeue_ready ----------------------------------------------------
 //-------------------------------------------------------------------
-// Returns the integer value of the start time of the next ready process.
-unsigned int get_next_start_time(){
-	process_t * proc 				= rt_queue;
-	unsigned int next_start = proc->start;
-	proc = proc->next;
-		while(proc != NULL){
-			if(proc->start < next_start){
-				next_start = proc->start;
-			}
-			proc = proc->next;
+// Takes the next process to run from the scheduling policy. With SRP,
+// jobs that may not run under the current system ceiling are set aside
+// (outside the policy) until it drops, and a job running for the first
+// time gets its frame on the shared stack.
+process_t * dequeue_ready(void) {
+	process_t *proc;
+
+	while ((proc = sched_policy.dequeue_next()) != NULL) {
+#if SRP_ENABLE
+		if (srp_blocked(proc)) {
+			srp_defer(proc);
+			continue;
+		}
+		if (proc->srp_level && !proc->sp && !(proc->sp = srp_start(proc))) {
+			// Shared stack full: wait for a job on it to complete.
+			srp_defer(proc);
+			continue;
 		}
-	return next_start;
+#endif
+		break;
+	}
+	return proc;
+}
+
+//-------------------------------------------------------------------
+// process_idle -----------------------------------------------------
+//-------------------------------------------------------------------
+// Sleeps until a process is ready, and returns it, or returns NULL once
+// no process is left to become ready. Must be called with interrupts
+// disabled; returns with interrupts disabled.
+//
+// PIT1 is already armed for the next timer, so the core simply waits in
+// WFI; no interrupt is taken until something happens.
+process_t * process_idle(void) {
+	process_t *proc;
+	uint64_t start = clock_cycles();
+
+	while (((proc = dequeue_ready()) == NULL) && process_count > 0) {
+		// WFI wakes on a pending interrupt even while PRIMASK is set;
+		// briefly enabling interrupts lets its handler run.
+		__WFI();
+		__enable_irq();
+		__disable_irq();
+	}
+
+	process_idle_cycles += clock_cycles() - start;
+	process_idle_time 	 = cycles_to_systime(process_idle_cycles) / 1000;
+	return proc;
 }
 
 //-------------------------------------------------------------------
@@ -164,59 +469,92 @@ unsigned int get_next_start_time(){
 //-------------------------------------------------------------------
 unsigned int * process_select (unsigned int * cursp) {
 	// If process was in the middle of executing, save cursp and
-	// queue the processes to the appropriate queue (rt or process_queue).
+	// hand it back to the scheduling policy, unless it is blocked: then
+	// whatever blocked it will enqueue it again.
 	if (cursp) {
 		current_process->sp = cursp;
-		if (current_process->rt == 1) {
-			push_onto_rt_queue(current_process);
-		} else {
-		push_tail_process(current_process);
+		if (!current_process->blocked) {
+			sched_policy.enqueue(current_process);
 		}
 	}
 	// cursp is NULL, meaing process either finished or nonexistent.
 	else {
 		// If a process existed, (and finished)
 		if (current_process) {
+			systime_t real_time = process_time();
+			// Ended while still holding a lock: account for the job (and
+			// queue its next one) under its own parameters.
+			if (current_process->inherited) {
+				lock_disinherit(current_process);
+			}
+			if (sched_policy.on_complete) {
+				sched_policy.on_complete(current_process);
+			}
 			// ..and if it was real-time: update global variable (met or miss).
 			if (current_process->rt == 1) {
-				unsigned int real_time = 1000*current_time.sec + current_time.msec;
 				if (real_time <= current_process->deadline) {
 					process_deadline_met++;
 				} else {
 					process_deadline_miss++;
 				}
 			}
-			// Then, free the process.
-			process_free(current_process);
+#if SRP_ENABLE
+			// Pop an SRP job off the shared stack; its next job gets a
+			// fresh frame when it is first dispatched.
+			if (current_process->srp_level) {
+				srp_complete(current_process);
+			}
+#endif
+			// A periodic process keeps its process_t and stack: rewind the
+			// stack and queue the next job one period later.
+			if (current_process->period) {
+				if (current_process->orig_sp) {
+					current_process->sp 		 = process_stack_reset(current_process->orig_sp, current_process->f);
+				}
+				current_process->start 		+= current_process->period;
+				current_process->deadline += current_process->period;
+				queue_rt_process(current_process, real_time);
+			}
+			// Otherwise, free the process.
+			else {
+				process_free(current_process);
+			}
 		}
 	}
 	
-	// Now, need to decide what process to queue next.
-	// If rt_queue is empty, run from process_queue.
-	if (rt_queue == NULL) {
-		current_process = pop_front_process();
-	}
-	// rt_queue is not empty
-	else {	
-		process_t * tmp = pop_rt_process();
-		// If there is a rt ready process, run it. Otherwise,
-		// check to see if process queue is empty. If it is not
-		// empty, run non-rt process. If it is empty, busy wait
-		// for a rt process to become ready.
-		if (tmp!=NULL) current_process = tmp;
-		else {
-			if (process_queue && !tmp) current_process = pop_front_process();
-			else if (!tmp && !process_queue) {
-				unsigned int delay = get_next_start_time();	// absolute start time
-				__enable_irq();
-				while((1000*current_time.sec + current_time.msec) < delay);
-				__disable_irq();
-				// Now, pop_rt_process() should return a ready process, not NULL
-				current_process = pop_rt_process();
-			}
+	// Now, let the scheduling policy decide what process to run next.
+	current_process = dequeue_ready();
+	// Nothing is ready, but processes are left (sleeping, waiting for a
+	// rt release, or blocked on data from an ISR): sleep until an
+	// interrupt makes one ready.
+	if (!current_process && process_count > 0) {
+		current_process = process_idle();
+	}
+
+	// Alone in the system: no quantum needed until something else is made
+	// ready (process_ready restarts it).
+	if (current_process && sched_policy.ready) {
+		if (!sched_policy.ready()) {
+			if (!quantum_stopped) quantum_stop();
+		} else if (quantum_stopped) {
+			quantum_start();
 		}
 	}
-		
+
+	// Only processes with their own quantum pay for a PIT0 reload.
+	if (current_process && current_process->quantum != quantum_loaded) {
+		quantum_load(current_process->quantum);
+	}
+
+	// First dispatch since release: record the latency.
+	if (current_process && current_process->released) {
+		unsigned int latency = DWT->CYCCNT - current_process->released_at;
+		if (latency > rt_dispatch_latency_max) rt_dispatch_latency_max = latency;
+		rt_dispatch_latency_total += latency;
+		rt_dispatch_count++;
+		current_process->released = 0;
+	}
+	
 		/*
 		  if ( (tmp == NULL) && (process_queue == NULL) )	{
 			// BUSY WAIT CASE
@@ -240,15 +578,89 @@ unsigned int * process_select (unsigned int * cursp) {
 	}
 }
 
+//-------------------------------------------------------------------
+// sleep_until ------------------------------------------------------
+//-------------------------------------------------------------------
+// Blocks the running process until the clock reaches wake.
+int sleep_until(systime_t wake) {
+	__disable_irq();
+	if (wake <= process_time()) {
+		__enable_irq();
+		return 0;
+	}
+	timer_init(&current_process->timer, wake_fire);
+	process_timer_add(&current_process->timer, wake);
+	// Blocked: process_select leaves it out of the policy until
+	// wake_fire hands it back.
+	current_process->blocked = 1;
+	process_blocked();	// re-enables interrupts
+	return 0;
+}
+
+//-------------------------------------------------------------------
+// process_sleep_until_us -------------------------------------------
+//-------------------------------------------------------------------
+int process_sleep_until_us(systime_t t) {
+	return sleep_until(t);
+}
+
+//-------------------------------------------------------------------
+// process_sleep_for_us ---------------------------------------------
+//-------------------------------------------------------------------
+int process_sleep_for_us(systime_t d) {
+	return sleep_until(process_time() + d);
+}
+
+//-------------------------------------------------------------------
+// process_sleep_until ----------------------------------------------
+//-------------------------------------------------------------------
+int process_sleep_until(realtime_t *t) {
+	return sleep_until(realtime_to_systime(t));
+}
+
+//-------------------------------------------------------------------
+// process_sleep_for ------------------------------------------------
+//-------------------------------------------------------------------
+int process_sleep_for(realtime_t *d) {
+	return sleep_until(process_time() + realtime_to_systime(d));
+}
+
+//-------------------------------------------------------------------
+// process_set_quantum ----------------------------------------------
+//-------------------------------------------------------------------
+void process_set_quantum(systime_t q) {
+	if (!current_process) return;
+
+	uint32_t m = __get_PRIMASK();
+	__disable_irq();
+	current_process->quantum = q;
+	quantum_load(q);
+	__set_PRIMASK(m);
+}
+
 //-------------------------------------------------------------------
 // process_start ----------------------------------------------------
 //-------------------------------------------------------------------
 void process_start (void){
-	SIM->SCGC6 					 |= SIM_SCGC6_PIT_MASK;
-	PIT->MCR 							= 0;
-	PIT->CHANNEL[0].LDVAL = DEFAULT_SYSTEM_CLOCK / 10;
-	PIT->CHANNEL[1].LDVAL = DEFAULT_SYSTEM_CLOCK / 1000;
+	// Start the DWT cycle counter, used for latency measurements.
+	CoreDebug->DEMCR 		 |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT 					= 0;
+	DWT->CTRL 					 |= DWT_CTRL_CYCCNTENA_Msk;
+
+#if (__FPU_USED == 1)
+	// Lazy FP stacking (the reset default): a process that used the FPU
+	// gets an extended exception frame, but S0-S15 are only written out if
+	// the context switch saves its S16-S31 (see 3140.s).
+	FPU->FPCCR 					 |= FPU_FPCCR_ASPEN_Msk | FPU_FPCCR_LSPEN_Msk;
+#endif
+
+	// Start the clock (PIT2/PIT3); this also enables the PIT.
+	clock_init();
+	PIT->CHANNEL[0].LDVAL = QUANTUM_CYCLES - 1;
+	PIT->CHANNEL[0].TCTRL = PIT_TCTRL_TEN_MASK | PIT_TCTRL_TIE_MASK;
+	quantum_loaded 				= 0;
 	
+	quantum_stopped = 0;
 	NVIC_EnableIRQ(PIT0_IRQn);
 	NVIC_EnableIRQ(PIT1_IRQn);
 	
@@ -256,13 +668,15 @@ void process_start (void){
 	NVIC_SetPriority(PIT1_IRQn, 0);	// highest priority
 	NVIC_SetPriority(PIT0_IRQn, 1);
 	NVIC_SetPriority(SVCall_IRQn, 1);
+	NVIC_SetPriority(PendSV_IRQn, (1 << __NVIC_PRIO_BITS) - 1);	// lowest priority
 	
-	// Other PIT1 control registers.
-	PIT->CHANNEL[1].TCTRL  = PIT_TCTRL_TIE_MASK;
-	PIT->CHANNEL[1].TCTRL |= PIT_TCTRL_TEN_MASK;
+	// PIT1 only runs when a timer is pending: arm it for the releases
+	// set up before the start.
+	timer_started = 1;
+	timer_rearm();
 	
 	// If NO processes were created, bail out real quick.
-	if ((process_queue == NULL) && (rt_queue == NULL)) {
+	if (process_count == 0) {
 		return;
 	}
 	process_begin();
@@ -272,6 +686,16 @@ void process_start (void){
 // process_create ---------------------------------------------------
 //-------------------------------------------------------------------
 int process_create (void (*f)(void), int n){
+	return process_create_prio(f, n, SCHED_PRIO_LOWEST);
+}
+
+//-------------------------------------------------------------------
+// process_create_prio ----------------------------------------------
+//-------------------------------------------------------------------
+int process_create_prio (void (*f)(void), int n, int prio){
+	if (prio < SCHED_PRIO_HIGHEST || prio > SCHED_PRIO_LOWEST) {
+		return -1;
+	}
 	unsigned int *sp = process_stack_init(f, n);
 	if (!sp) {
 		return -1;
@@ -283,20 +707,45 @@ int process_create (void (*f)(void), int n){
 	}
 	
 	proc->n 									= n;
+	proc->f 									= f;
 	proc->rt 									= 0;
 	proc->sp = proc->orig_sp 	= sp;
 	proc->next								= NULL;
-	proc->start								=	NULL;
-	proc->deadline						= NULL;
+	proc->blocked 						= 0;
+	proc->blocked_on 					= NULL;
+	proc->locks_held 					= 0;
+	proc->inherited 					= 0;
+	proc->released 						= 0;
+	proc->start								=	0;
+	proc->deadline						= 0;
+	proc->period 							= 0;
+	proc->prio 								= prio;
+	proc->task 								= -1;
+	proc->srp_level 					= 0;
+	proc->quantum 						= 0;
 
-	push_tail_process(proc);
+	uint32_t m = __get_PRIMASK();
+	__disable_irq();
+	process_count++;
+	process_ready(proc);
+	__set_PRIMASK(m);
 	return 0;
 }
 
 //-------------------------------------------------------------------
-// process_rt_create ------------------------------------------------
+// rt_create --------------------------------------------------------
 //-------------------------------------------------------------------
-int process_rt_create(void (*f)(void), int n, realtime_t *start, realtime_t *deadline){
+// Creates a real-time process released start us from now, with a
+// deadline deadline us after each release. A non-zero period makes it
+// periodic. A non-zero wcet (worst-case execution time) subjects it to
+// admission control: it is rejected with RT_ERR_UNSCHEDULABLE if the
+// admitted processes plus this one would fail the schedulability test.
+// prio is its SCHED_FP level, used by the test as well.
+int rt_create(void (*f)(void), int n, systime_t start, systime_t deadline, systime_t period, systime_t wcet, int prio){
+	// The admission test works on 32-bit times.
+	if (wcet && (deadline > 0xFFFFFFFFu || period > 0xFFFFFFFFu)) {
+		return -1;
+	}
 	unsigned int *sp = process_stack_init(f, n);
 	if (!sp) {
 		return -1;
@@ -307,14 +756,165 @@ int process_rt_create(void (*f)(void), int n, realtime_t *start, realtime_t *dea
 		return -1;
 	}
 
-	unsigned int curr_time 		= 1000*current_time.sec + current_time.msec;
+	systime_t curr_time 			= process_time();
 	proc->n 									= n;
+	proc->f 									= f;
 	proc->rt 									= 1;
 	proc->sp = proc->orig_sp 	= sp;
 	proc->next 								= NULL;
-	proc->start 							= curr_time + ( 1000 * start->sec ) + start->msec;
-	proc->deadline 						= proc->start + ( 1000 * deadline->sec ) + deadline->msec;
+	proc->blocked 						= 0;
+	proc->blocked_on 					= NULL;
+	proc->locks_held 					= 0;
+	proc->inherited 					= 0;
+	proc->released 						= 0;
+	proc->start 							= curr_time + start;
+	proc->deadline 						= proc->start + deadline;
+	proc->period 							= period;
+	proc->prio 								= prio;
+	proc->task 								= -1;
+	proc->srp_level 					= 0;
+	proc->quantum 						= 0;
 	
-	push_onto_rt_queue(proc);
+	// The queues are shared with PIT1_IRQHandler. Bounding the number of
+	// rt processes keeps the rt heaps from ever overflowing.
+	uint32_t m = __get_PRIMASK();
+	__disable_irq();
+	int err = 0;
+	if (rt_process_count >= RT_HEAP_CAPACITY) {
+		err = -1;
+	} else if (wcet) {
+		rt_task_t *task = &rt_tasks[rt_task_count];
+		task->wcet 			= (unsigned int) wcet;
+		task->deadline 	= (unsigned int) deadline;
+		task->period 		= (unsigned int) period;
+#if SCHED_POLICY == SCHED_RM
+		task->prio 			= period ? period : deadline;
+#else
+		task->prio 			= proc->prio;
+#endif
+		if (admission_test(rt_task_count + 1)) {
+			rt_task_proc[rt_task_count] = proc;
+			proc->task = rt_task_count++;
+		} else {
+			err = RT_ERR_UNSCHEDULABLE;
+		}
+	}
+	if (err < 0) {
+		__set_PRIMASK(m);
+		process_stack_free(sp, n);
+		free(proc);
+		return err;
+	}
+	process_count++;
+	rt_process_count++;
+	queue_rt_process(proc, curr_time);
+	__set_PRIMASK(m);
 	return 0;
-} 
+}
+
+//-------------------------------------------------------------------
+// process_rt_create_us ---------------------------------------------
+//-------------------------------------------------------------------
+int process_rt_create_us(void (*f)(void), int n, systime_t start, systime_t deadline, systime_t period, systime_t wcet){
+	return rt_create(f, n, start, deadline, period, wcet, SCHED_PRIO_HIGHEST);
+}
+
+//-------------------------------------------------------------------
+// process_rt_create ------------------------------------------------
+//-------------------------------------------------------------------
+int process_rt_create(void (*f)(void), int n, realtime_t *start, realtime_t *deadline){
+	return rt_create(f, n, realtime_to_systime(start), realtime_to_systime(deadline), 0, 0, SCHED_PRIO_HIGHEST);
+}
+
+//-------------------------------------------------------------------
+// process_rt_periodic ----------------------------------------------
+//-------------------------------------------------------------------
+int process_rt_periodic(void (*f)(void), int n, realtime_t *start, realtime_t *deadline, realtime_t *period){
+	systime_t period_us = realtime_to_systime(period);
+	if (period_us == 0) {
+		return -1;
+	}
+	return rt_create(f, n, realtime_to_systime(start), realtime_to_systime(deadline), period_us, 0, SCHED_PRIO_HIGHEST);
+}
+
+//-------------------------------------------------------------------
+// process_rt_create_wcet -------------------------------------------
+//-------------------------------------------------------------------
+int process_rt_create_wcet(void (*f)(void), int n, realtime_t *start, realtime_t *deadline, realtime_t *period, realtime_t *wcet){
+	systime_t period_us 	= period ? realtime_to_systime(period) : 0;
+	systime_t wcet_us 		= realtime_to_systime(wcet);
+	if ((period && period_us == 0) || wcet_us == 0) {
+		return -1;
+	}
+	return rt_create(f, n, realtime_to_systime(start), realtime_to_systime(deadline), period_us, wcet_us, SCHED_PRIO_HIGHEST);
+}
+
+//-------------------------------------------------------------------
+// process_rt_create_prio -------------------------------------------
+//-------------------------------------------------------------------
+int process_rt_create_prio(void (*f)(void), int n, realtime_t *start, realtime_t *deadline, realtime_t *period, realtime_t *wcet, int prio){
+	systime_t period_us 	= period ? realtime_to_systime(period) : 0;
+	systime_t wcet_us 		= wcet ? realtime_to_systime(wcet) : 0;
+	if ((period && period_us == 0) || (wcet && wcet_us == 0)) {
+		return -1;
+	}
+	if (prio < SCHED_PRIO_HIGHEST || prio > SCHED_PRIO_LOWEST) {
+		return -1;
+	}
+	return rt_create(f, n, realtime_to_systime(start), realtime_to_systime(deadline), period_us, wcet_us, prio);
+}
+
+#if SRP_ENABLE
+//-------------------------------------------------------------------
+// process_rt_create_srp --------------------------------------------
+//-------------------------------------------------------------------
+// Like rt_create, but the job has no stack of its own: it is given a
+// frame on the shared SRP stack each time it is dispatched for the
+// first time. Its preemption level is its relative deadline.
+int process_rt_create_srp(void (*f)(void), realtime_t *start, realtime_t *deadline, realtime_t *period, unsigned int resources){
+	systime_t start_us 		= realtime_to_systime(start);
+	systime_t deadline_us = realtime_to_systime(deadline);
+	systime_t period_us 	= period ? realtime_to_systime(period) : 0;
+	// Preemption levels are 32-bit.
+	if (deadline_us == 0 || deadline_us > 0xFFFFFFFFu || (period && period_us == 0)) {
+		return -1;
+	}
+	process_t *proc = (process_t*) malloc(sizeof(process_t));
+	if (!proc) {
+		return -1;
+	}
+
+	systime_t curr_time 			= process_time();
+	proc->n 									= 0;
+	proc->f 									= f;
+	proc->rt 									= 1;
+	proc->sp = proc->orig_sp 	= NULL;
+	proc->next 								= NULL;
+	proc->blocked 						= 0;
+	proc->blocked_on 					= NULL;
+	proc->locks_held 					= 0;
+	proc->inherited 					= 0;
+	proc->released 						= 0;
+	proc->start 							= curr_time + start_us;
+	proc->deadline 						= proc->start + deadline_us;
+	proc->period 							= period_us;
+	proc->prio 								= SCHED_PRIO_HIGHEST;
+	proc->task 								= -1;
+	proc->srp_level 					= (unsigned int) deadline_us;
+	proc->quantum 						= 0;
+
+	uint32_t m = __get_PRIMASK();
+	__disable_irq();
+	if (rt_process_count >= RT_HEAP_CAPACITY) {
+		__set_PRIMASK(m);
+		free(proc);
+		return -1;
+	}
+	srp_declare((unsigned int) deadline_us, resources);
+	process_count++;
+	rt_process_count++;
+	queue_rt_process(proc, curr_time);
+	__set_PRIMASK(m);
+	return 0;
+}
+#endif
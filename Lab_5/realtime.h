@@ -13,26 +13,156 @@
 #ifndef __REALTIME_H__
 #define __REALTIME_H__
 
+#include <stdint.h>
+
 typedef struct {
 	unsigned int sec;
 	unsigned int msec;
 } realtime_t;
 
-// The current time relative to process_start
-extern realtime_t current_time;
+// Time in us relative to process_start. 64 bits, so it never wraps.
+// Durations (start offsets, deadlines, periods) use the same unit.
+typedef uint64_t systime_t;
+
+// Resolution of systime_t, in Hz.
+#define SYSTIME_HZ 1000000
+
+// Frequency of the free-running hardware clock (the PIT clock).
+#define CLOCK_HZ DEFAULT_SYSTEM_CLOCK
+
+// Rate of the timing wheel behind releases, sleeps and policy timers: a
+// timer fires on the first wheel tick at or after its time. This only
+// sets the granularity of timer events; nothing interrupts at this rate.
+// Must divide SYSTIME_HZ. Timers may be armed up to 2^31 ticks ahead.
+#ifndef TICK_HZ
+#define TICK_HZ 10000
+#endif
+#define TICK_US (SYSTIME_HZ / TICK_HZ)
+
+/* Return the current time. Safe to call from any context: a read that
+ * races with the counter is retried, never torn. 0 until process_start.
+ * Implemented in clock.c.
+ */
+systime_t process_time(void);
+
+/* Return the raw clock, in CLOCK_HZ cycles since process_start. */
+uint64_t clock_cycles(void);
+
+/* Convert between clock cycles and systime_t. cycles_to_systime rounds
+ * down and systime_to_cycles rounds up, so neither lands early.
+ */
+systime_t cycles_to_systime(uint64_t cycles);
+uint64_t systime_to_cycles(systime_t time);
+
+/* Start the clock. Called by process_start. */
+void clock_init(void);
+
+/* Conversions between systime_t and realtime_t (ms resolution). */
+systime_t realtime_to_systime(const realtime_t *t);
+void systime_to_realtime(systime_t time, realtime_t *t);
+
+/* The current time relative to process_start, as sec/msec. Read on demand
+ * from the clock, and returned by value: every use of current_time is a
+ * new snapshot, so read it once into a realtime_t rather than taking sec
+ * and msec from two reads. Kept for code written against realtime_t, new
+ * code should use process_time().
+ */
+realtime_t process_current_time(void);
+#define current_time (process_current_time())
 
 // The number of processes that have terminated before or after their deadline, respectively.
 extern int process_deadline_met;
 extern int process_deadline_miss;
 
+// Total time, in ms, the scheduler has spent asleep waiting for a job release.
+extern unsigned int process_idle_time;
+
+// Event timer (PIT1) interrupts taken, and the core cycles spent in them.
+// PIT1 only fires for timer events (releases, sleeps, the CBS budget),
+// not every ms.
+extern unsigned int timer_irq_count;
+extern unsigned int timer_irq_cycles;
+
+// Worst delay, in clock cycles, between the time PIT1 was armed for and
+// entry into its handler: the interrupt latency left by code running
+// with interrupts disabled, the context switch included.
+extern unsigned int timer_irq_latency_max;
+
+// Delay between a job's release and its first dispatch, in core cycles.
+// The average is rt_dispatch_latency_total / rt_dispatch_count.
+extern unsigned int rt_dispatch_latency_max;
+extern unsigned int rt_dispatch_latency_total;
+extern unsigned int rt_dispatch_count;
+
+/* Create a new realtime process out of the function f, released start us
+ * from now, with a deadline deadline us after each release. A non-zero
+ * period makes it periodic, and a non-zero wcet subjects it to admission
+ * control, as in process_rt_create_wcet. The realtime_t entry points below
+ * are adapters for this one, with ms resolution.
+ * Returns the same values as process_rt_create_wcet.
+ */
+int process_rt_create_us(void (*f)(void), int n, systime_t start, systime_t deadline, systime_t period, systime_t wcet);
+
 /* Create a new realtime process out of the function f with the given parameters.
- * Returns -1 if unable to malloc a new process_t, 0 otherwise.
+ * Returns -1 if unable to malloc a new process_t or the real-time queue is full, 0 otherwise.
  */
 int process_rt_create(void (*f)(void), int n, realtime_t* start, realtime_t* deadline);
 
 /* Create a new periodic realtime process out of the function f with the given parameters.
- * Returns -1 if unable to malloc a new process_t, 0 otherwise.
+ * The first job is released at start; each job must finish within deadline of its
+ * release, and a new job is released every period. The process_t and stack are
+ * reused for every job, so no memory is allocated after creation.
+ * Returns -1 if unable to malloc a new process_t, the real-time queue is full,
+ * or period is zero; 0 otherwise.
  */
 int process_rt_periodic(void (*f)(void), int n, realtime_t *start, realtime_t *deadline, realtime_t *period);
 
+/* Returned by process_rt_create_wcet when the new process would make the
+ * admitted task set miss deadlines.
+ */
+#define RT_ERR_UNSCHEDULABLE -2
+
+/* Create a new realtime process, like process_rt_create (period == NULL) or
+ * process_rt_periodic, whose worst-case execution time is at most wcet.
+ * The process is only admitted if it and every process previously admitted
+ * this way still pass the schedulability test of the active scheduling policy
+ * (demand bound for EDF, response-time analysis for fixed priority). Processes
+ * created without a wcet are not part of the test.
+ * Returns RT_ERR_UNSCHEDULABLE if the test fails, -1 on the same errors as
+ * process_rt_periodic or if wcet is zero, 0 otherwise.
+ */
+int process_rt_create_wcet(void (*f)(void), int n, realtime_t *start, realtime_t *deadline, realtime_t *period, realtime_t *wcet);
+
+/* Create a new realtime process like process_rt_create_wcet, at fixed
+ * priority prio, from 0 (highest, the priority of the other realtime entry
+ * points) to 31. Under SCHED_FP the job is queued at that level, and the
+ * response-time test only counts higher and equal levels as interference.
+ * Other policies ignore prio. period may be NULL for a one-shot job, and
+ * wcet NULL to skip admission control.
+ * Returns -1 if prio is out of range, otherwise as process_rt_create_wcet.
+ */
+int process_rt_create_prio(void (*f)(void), int n, realtime_t *start, realtime_t *deadline, realtime_t *period, realtime_t *wcet, int prio);
+
+/* Block the calling process until current_time reaches t. While asleep it
+ * is not scheduled and takes no CPU time; a PIT1 timer event wakes it at t.
+ * Returns at once if t has passed. Returns 0.
+ * Must be called from a process, with interrupts enabled.
+ */
+int process_sleep_until(realtime_t *t);
+
+/* Like process_sleep_until, for d from now. Replaces busy loops such as
+ * delay(), whose length also depends on the clock.
+ */
+int process_sleep_for(realtime_t *d);
+
+/* process_sleep_until and process_sleep_for with us resolution. */
+int process_sleep_until_us(systime_t t);
+int process_sleep_for_us(systime_t d);
+
+/* Set the PIT0 quantum of the calling process to q us, from now on; 0
+ * restores the default of 100 ms. Only switches between processes with
+ * different quanta reprogram PIT0.
+ */
+void process_set_quantum(systime_t q);
+
 #endif /* __REALTIME_H_INCLUDED */
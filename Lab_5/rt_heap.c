@@ -0,0 +1,116 @@
+#include "rt_heap.h"
+
+//-------------------------------------------------------------------
+// node_less --------------------------------------------------------
+//-------------------------------------------------------------------
+// Orders by key, then by insertion order for equal keys.
+static int node_less(rt_heap_node_t *a, rt_heap_node_t *b) {
+	if (a->key != b->key) return a->key < b->key;
+	return (int)(a->seq - b->seq) < 0;
+}
+
+//-------------------------------------------------------------------
+// sift_up ----------------------------------------------------------
+//-------------------------------------------------------------------
+// Stores node at slot i or above, moving parents down until its slot is found.
+static void sift_up(rt_heap_t *heap, int i, rt_heap_node_t node) {
+	while (i > 0) {
+		int parent = (i - 1) / 2;
+		if (!node_less(&node, &heap->node[parent])) break;
+		heap->node[i] = heap->node[parent];
+		i = parent;
+	}
+	heap->node[i] = node;
+}
+
+//-------------------------------------------------------------------
+// sift_down --------------------------------------------------------
+//-------------------------------------------------------------------
+// Stores node at slot i or below, moving the smaller child up until its slot is found.
+static void sift_down(rt_heap_t *heap, int i, rt_heap_node_t node) {
+	for (;;) {
+		int child = 2 * i + 1;
+		if (child >= heap->size) break;
+		if (child + 1 < heap->size && node_less(&heap->node[child + 1], &heap->node[child])) {
+			child++;
+		}
+		if (!node_less(&heap->node[child], &node)) break;
+		heap->node[i] = heap->node[child];
+		i = child;
+	}
+	heap->node[i] = node;
+}
+
+//-------------------------------------------------------------------
+// rt_heap_init -----------------------------------------------------
+//-------------------------------------------------------------------
+void rt_heap_init(rt_heap_t *heap) {
+	heap->size = 0;
+	heap->seq  = 0;
+}
+
+//-------------------------------------------------------------------
+// rt_heap_push -----------------------------------------------------
+//-------------------------------------------------------------------
+int rt_heap_push(rt_heap_t *heap, uint64_t key, process_t *proc) {
+	if (heap->size >= RT_HEAP_CAPACITY) return -1;
+
+	rt_heap_node_t node;
+	node.key  = key;
+	node.seq  = heap->seq++;
+	node.proc = proc;
+
+	sift_up(heap, heap->size++, node);
+	return 0;
+}
+
+//-------------------------------------------------------------------
+// rt_heap_pop ------------------------------------------------------
+//-------------------------------------------------------------------
+process_t * rt_heap_pop(rt_heap_t *heap) {
+	if (heap->size == 0) return NULL;
+
+	process_t *proc = heap->node[0].proc;
+	rt_heap_node_t last = heap->node[--heap->size];
+
+	sift_down(heap, 0, last);
+	return proc;
+}
+
+//-------------------------------------------------------------------
+// rt_heap_peek -----------------------------------------------------
+//-------------------------------------------------------------------
+process_t * rt_heap_peek(rt_heap_t *heap) {
+	if (heap->size == 0) return NULL;
+	return heap->node[0].proc;
+}
+
+//-------------------------------------------------------------------
+// rt_heap_peek_key -------------------------------------------------
+//-------------------------------------------------------------------
+uint64_t rt_heap_peek_key(rt_heap_t *heap) {
+	return heap->node[0].key;
+}
+
+//-------------------------------------------------------------------
+// rt_heap_remove ---------------------------------------------------
+//-------------------------------------------------------------------
+int rt_heap_remove(rt_heap_t *heap, process_t *proc) {
+	int i;
+
+	for (i = 0; i < heap->size; i++) {
+		if (heap->node[i].proc == proc) break;
+	}
+	if (i == heap->size) return -1;
+
+	// Fill the hole with the last node, which may need to move either way.
+	rt_heap_node_t last = heap->node[--heap->size];
+	if (i < heap->size) {
+		if (i > 0 && node_less(&last, &heap->node[(i - 1) / 2])) {
+			sift_up(heap, i, last);
+		} else {
+			sift_down(heap, i, last);
+		}
+	}
+	return 0;
+}
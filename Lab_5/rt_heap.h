@@ -0,0 +1,52 @@
+#ifndef __RT_HEAP_H__
+#define __RT_HEAP_H__
+
+#include "3140_concur.h"
+
+/**
+ * Maximum number of real-time jobs a single heap can hold. The heap storage
+ * is a fixed array so no allocation happens on the scheduling path; override
+ * this at build time if more jobs are needed.
+ */
+#ifndef RT_HEAP_CAPACITY
+#define RT_HEAP_CAPACITY 64
+#endif
+
+/**
+ * One heap slot. seq breaks ties between equal keys so that jobs with the
+ * same key pop in the order they were pushed (FIFO), like the old list.
+ */
+typedef struct {
+	uint64_t key;
+	unsigned int seq;
+	process_t *proc;
+} rt_heap_node_t;
+
+/**
+ * Array-backed binary min-heap of processes ordered by key.
+ */
+typedef struct {
+	int size;
+	unsigned int seq;
+	rt_heap_node_t node[RT_HEAP_CAPACITY];
+} rt_heap_t;
+
+/* Empty the heap. */
+void rt_heap_init(rt_heap_t *heap);
+
+/* Insert proc with the given key in O(log n). Returns -1 if the heap is full, 0 otherwise. */
+int rt_heap_push(rt_heap_t *heap, uint64_t key, process_t *proc);
+
+/* Remove and return the process with the smallest key in O(log n), or NULL if empty. */
+process_t * rt_heap_pop(rt_heap_t *heap);
+
+/* Return the process with the smallest key without removing it, or NULL if empty. */
+process_t * rt_heap_peek(rt_heap_t *heap);
+
+/* Remove proc from the heap in O(n). Returns -1 if it is not in the heap, 0 otherwise. */
+int rt_heap_remove(rt_heap_t *heap, process_t *proc);
+
+/* Return the smallest key. Only valid if the heap is not empty. */
+uint64_t rt_heap_peek_key(rt_heap_t *heap);
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef __SCHED_H__
+#define __SCHED_H__
+
+#include "3140_concur.h"
+#include "realtime.h"
+#include "timer.h"
+
+/**
+ * Scheduling policies. Exactly one is compiled in, chosen with SCHED_POLICY
+ * at build time (e.g. -DSCHED_POLICY=SCHED_RM); the others compile out.
+ *
+ *   SCHED_EDF  Earliest deadline first for real-time processes, round-robin
+ *              for the rest once no real-time process is ready.
+ *   SCHED_RM   Rate monotonic: real-time processes by period (relative
+ *              deadline for one-shot jobs), then round-robin.
+ *   SCHED_FP   Fixed priority on the prio field, round-robin within a level.
+ *   SCHED_RR   Round-robin over every ready process, deadlines ignored.
+ */
+#define SCHED_EDF 	0
+#define SCHED_RM 		1
+#define SCHED_FP 		2
+#define SCHED_RR 		3
+
+#ifndef SCHED_POLICY
+#define SCHED_POLICY SCHED_EDF
+#endif
+
+/* Priorities used by SCHED_FP: 0 is the highest, 32 levels in all. */
+#define SCHED_PRIO_HIGHEST 	0
+#define SCHED_PRIO_LOWEST 	31
+
+/**
+ * Policy operations. Only ready processes are handed to a policy: jobs that
+ * have not been released yet stay on the release queue in process.c.
+ * All operations are called with interrupts disabled.
+ */
+typedef struct {
+	/* Make proc ready to run (created, released or preempted). */
+	void (*enqueue)(process_t *proc);
+	/* Remove and return the process to run next, or NULL if none is ready. */
+	process_t * (*dequeue_next)(void);
+	/* Called on every PIT1 timer event (releases, wake-ups, policy timers),
+	   after the timers fired. Return non-zero if cur must be preempted
+	   right away. May be NULL. */
+	int (*on_tick)(process_t *cur);
+	/* Called when a job of proc has finished, before it is freed or
+	   re-queued for its next period. May be NULL. */
+	void (*on_complete)(process_t *proc);
+	/* Remove a ready process that was passed to enqueue. */
+	void (*remove)(process_t *proc);
+	/* Return non-zero if a must run before b. */
+	int (*precedes)(process_t *a, process_t *b);
+	/* Return non-zero if any process is ready. May be NULL: then the
+	   quantum timer is never stopped. */
+	int (*ready)(void);
+} sched_policy_t;
+
+/* The policy selected by SCHED_POLICY. */
+extern const sched_policy_t sched_policy;
+
+#if SCHED_POLICY == SCHED_EDF
+/**
+ * Constant Bandwidth Server. Under EDF, the non-real-time processes in
+ * process_queue are scheduled as a single server that may use at most
+ * CBS_BUDGET_MS of CPU every CBS_PERIOD_MS, with its own deadline, so real-time
+ * load cannot starve them (and they cannot delay real-time jobs by more
+ * than that bandwidth). Set CBS_ENABLE to 0 to let real-time processes
+ * always win, as before.
+ */
+#ifndef CBS_ENABLE
+#define CBS_ENABLE 1
+#endif
+#ifndef CBS_BUDGET_MS
+#define CBS_BUDGET_MS 10
+#endif
+#ifndef CBS_PERIOD_MS
+#define CBS_PERIOD_MS 100
+#endif
+
+#if CBS_ENABLE
+typedef struct {
+	unsigned int budget;			// us of CPU per period
+	unsigned int period;			// us
+	unsigned int remaining;		// us left in the current budget
+	systime_t deadline;				// absolute server deadline, us
+	int idle;									// no non-real-time process is ready
+	/* Statistics. delivered / elapsed time is the bandwidth actually used. */
+	systime_t delivered;			// us of CPU given to process_queue
+	unsigned int replenished;	// number of budget recharges
+} cbs_server_t;
+
+extern cbs_server_t cbs_server;
+
+/* Change the server bandwidth, budget and period in ms. Call before creating real-time processes
+   with a wcet, since admitted processes are not re-checked.
+   Returns -1 if budget is zero or larger than period, 0 otherwise. */
+int cbs_configure(unsigned int budget, unsigned int period);
+#endif
+#endif
+
+/* One-shot timers for the policies, on the same wheel as releases and
+   sleeps: t->fire runs from PIT1_IRQHandler once the clock reaches when,
+   followed by on_tick. Implemented in process.c. */
+void process_timer_add(timer_node_t *t, systime_t when);
+void process_timer_cancel(timer_node_t *t);
+
+/* FIFO of processes shared by the policies, implemented in process.c. */
+void push_tail_process(process_t *proc);
+process_t * pop_front_process(void);
+void remove_process(process_t *proc);
+
+/* Hands proc to the policy, and restarts the quantum timer if it was
+   stopped because only the running process was runnable. Use this rather
+   than sched_policy.enqueue to make a process ready. Implemented in
+   process.c; call with interrupts disabled. */
+void process_ready(process_t *proc);
+
+/* Clears proc->blocked and makes it ready. Use this to wake a blocked
+   process: if proc blocked but has not been switched out yet, it is left
+   for process_select to queue, so it is never queued twice. Implemented
+   in process.c; call with interrupts disabled. */
+void process_wake(process_t *proc);
+
+/* Wait queues of blocked processes (locks, condition variables, message
+   queues), kept in the order the policy runs them. Implemented in
+   process.c; call with interrupts disabled. unpark_process makes the
+   first waiter ready and returns it, or returns NULL if there is none. */
+void park_process(process_t **head, process_t **tail, process_t *proc);
+process_t * unpark_process(process_t **head, process_t **tail);
+
+/* Gives proc, which must not be queued, its own scheduling parameters
+   back after priority inheritance. Implemented in lock.c; call with
+   interrupts disabled. */
+void lock_disinherit(process_t *proc);
+
+#endif
@@ -0,0 +1,217 @@
+#include "sched.h"
+
+#if SCHED_POLICY == SCHED_EDF
+
+#include "shared_structs.h"
+#include "rt_heap.h"
+#include "realtime.h"
+
+// Released real-time jobs, ordered by absolute deadline.
+static rt_heap_t rt_queue;
+
+#if CBS_ENABLE
+cbs_server_t cbs_server = { CBS_BUDGET_MS * 1000, CBS_PERIOD_MS * 1000, CBS_BUDGET_MS * 1000, 0, 1, 0, 0 };
+
+//-------------------------------------------------------------------
+// cbs_configure ----------------------------------------------------
+//-------------------------------------------------------------------
+int cbs_configure(unsigned int budget, unsigned int period) {
+	if (budget == 0 || budget > period) return -1;
+
+	uint32_t m = __get_PRIMASK();
+	__disable_irq();
+	cbs_server.budget 		= budget * 1000;
+	cbs_server.period 		= period * 1000;
+	cbs_server.remaining 	= budget * 1000;
+	__set_PRIMASK(m);
+	return 0;
+}
+
+//-------------------------------------------------------------------
+// cbs_wake ---------------------------------------------------------
+//-------------------------------------------------------------------
+// An idle server got work. Keep the current budget and deadline only if
+// using them would not exceed the server bandwidth budget/period;
+// otherwise start a fresh server period now.
+static void cbs_wake(void) {
+	systime_t now = process_time();
+
+	cbs_server.idle = 0;
+	if ((cbs_server.deadline <= now) ||
+	    ((unsigned long long)cbs_server.remaining * cbs_server.period >=
+	     (unsigned long long)(cbs_server.deadline - now) * cbs_server.budget)) {
+		cbs_server.deadline 	= now + cbs_server.period;
+		cbs_server.remaining 	= cbs_server.budget;
+	}
+}
+
+// While a non-real-time process runs, the server is charged for the time
+// elapsed since cbs_since (clock cycles). cbs_carry keeps the fraction of
+// a us not charged yet between runs.
+static int cbs_running = 0;
+static uint64_t cbs_since;
+static unsigned int cbs_carry = 0;
+
+// Fires when the budget of the running server should be used up, so that
+// the exhaustion is noticed without a periodic tick.
+static timer_node_t cbs_timer;
+
+//-------------------------------------------------------------------
+// cbs_charge -------------------------------------------------------
+//-------------------------------------------------------------------
+// Charge the server for the whole us it ran since cbs_since. An
+// exhausted budget is recharged at once, and the deadline postponed by
+// one server period.
+static void cbs_charge(void) {
+	systime_t used = cycles_to_systime(clock_cycles() - cbs_since);
+
+	cbs_since 						+= systime_to_cycles(used);
+	cbs_server.delivered 	+= used;
+	while (used >= cbs_server.remaining) {
+		used 								 -= cbs_server.remaining;
+		cbs_server.remaining 	= cbs_server.budget;
+		cbs_server.deadline  += cbs_server.period;
+		cbs_server.replenished++;
+	}
+	cbs_server.remaining -= used;
+}
+
+//-------------------------------------------------------------------
+// cbs_timer_fire ---------------------------------------------------
+//-------------------------------------------------------------------
+// Nothing to do here: edf_on_tick runs right after and charges.
+static void cbs_timer_fire(timer_node_t *t) {
+}
+
+//-------------------------------------------------------------------
+// cbs_run ----------------------------------------------------------
+//-------------------------------------------------------------------
+// A non-real-time process was dispatched: start charging the server.
+static void cbs_run(void) {
+	cbs_running = 1;
+	cbs_since 	= clock_cycles() - cbs_carry;
+	timer_init(&cbs_timer, cbs_timer_fire);
+	process_timer_add(&cbs_timer, process_time() + cbs_server.remaining);
+}
+
+//-------------------------------------------------------------------
+// cbs_stop ---------------------------------------------------------
+//-------------------------------------------------------------------
+// The running process is being switched out: settle the server's time.
+static void cbs_stop(void) {
+	if (!cbs_running) return;
+	cbs_charge();
+	cbs_carry 	= clock_cycles() - cbs_since;
+	cbs_running = 0;
+	process_timer_cancel(&cbs_timer);
+}
+#endif
+
+//-------------------------------------------------------------------
+// edf_enqueue ------------------------------------------------------
+//-------------------------------------------------------------------
+static void edf_enqueue(process_t *proc) {
+	if (proc->rt == 1) {
+		rt_heap_push(&rt_queue, proc->deadline, proc);
+	} else {
+#if CBS_ENABLE
+		if (cbs_server.idle) {
+			cbs_wake();
+			// The server now competes with the running job: preempt it if
+			// the server's deadline is earlier.
+			if (current_process && current_process->rt == 1 &&
+			    cbs_server.deadline < current_process->deadline) {
+				process_reschedule();
+			}
+		}
+#endif
+		push_tail_process(proc);
+	}
+}
+
+//-------------------------------------------------------------------
+// edf_dequeue_next -------------------------------------------------
+//-------------------------------------------------------------------
+// Without a server, a released rt process always wins; otherwise run
+// from process_queue. With the server, process_queue competes as one
+// job with the server deadline.
+static process_t * edf_dequeue_next(void) {
+	process_t *proc;
+#if CBS_ENABLE
+	// Every switch comes through here: stop charging whatever ran so far.
+	cbs_stop();
+	if (!process_queue) {
+		cbs_server.idle = 1;
+	} else if (rt_queue.size == 0 || cbs_server.deadline < rt_heap_peek_key(&rt_queue)) {
+		cbs_run();
+		return pop_front_process();
+	}
+#endif
+	proc = rt_heap_pop(&rt_queue);
+	if (!proc) {
+		proc = pop_front_process();
+#if CBS_ENABLE
+		if (proc) cbs_run();
+#endif
+	}
+	return proc;
+}
+
+//-------------------------------------------------------------------
+// edf_on_tick ------------------------------------------------------
+//-------------------------------------------------------------------
+// Preempt when a ready job (or the server) has an earlier deadline than
+// cur, or cur is not real-time at all.
+static int edf_on_tick(process_t *cur) {
+#if CBS_ENABLE
+	// Charge the server for the time so far, and move its budget timer to
+	// where the (possibly recharged) budget now runs out.
+	if (cur->rt == 0 && cbs_running) {
+		cbs_charge();
+		process_timer_cancel(&cbs_timer);
+		process_timer_add(&cbs_timer, process_time() + cbs_server.remaining);
+		return (rt_queue.size > 0) && (rt_heap_peek_key(&rt_queue) <= cbs_server.deadline);
+	}
+	// process_queue runs as one job with the server deadline.
+	if (cur->rt == 1 && process_queue && cbs_server.deadline < cur->deadline) return 1;
+#endif
+	if (rt_queue.size == 0) return 0;
+	return (cur->rt == 0) || (rt_heap_peek_key(&rt_queue) < cur->deadline);
+}
+
+//-------------------------------------------------------------------
+// edf_remove -------------------------------------------------------
+//-------------------------------------------------------------------
+static void edf_remove(process_t *proc) {
+	if (proc->rt == 1) {
+		rt_heap_remove(&rt_queue, proc);
+	} else {
+		remove_process(proc);
+	}
+}
+
+//-------------------------------------------------------------------
+// edf_precedes -----------------------------------------------------
+//-------------------------------------------------------------------
+static int edf_precedes(process_t *a, process_t *b) {
+	return (a->rt == 1) && ((b->rt == 0) || (a->deadline < b->deadline));
+}
+
+//-------------------------------------------------------------------
+// edf_ready --------------------------------------------------------
+//-------------------------------------------------------------------
+static int edf_ready(void) {
+	return rt_queue.size > 0 || process_queue != NULL;
+}
+
+const sched_policy_t sched_policy = {
+	edf_enqueue,
+	edf_dequeue_next,
+	edf_on_tick,
+	NULL,
+	edf_remove,
+	edf_precedes,
+	edf_ready
+};
+
+#endif
@@ -0,0 +1,107 @@
+#include "sched.h"
+
+#if SCHED_POLICY == SCHED_FP
+
+#include "shared_structs.h"
+
+// Ready processes, one FIFO per priority level. Bit (31 - prio) of
+// prio_bitmap is set when level prio is not empty, so the highest ready
+// level is the number of leading zeros: a single CLZ instruction.
+static unsigned int prio_bitmap = 0;
+static process_t * prio_head[SCHED_PRIO_LOWEST + 1];
+static process_t * prio_tail[SCHED_PRIO_LOWEST + 1];
+
+//-------------------------------------------------------------------
+// fp_enqueue -------------------------------------------------------
+//-------------------------------------------------------------------
+static void fp_enqueue(process_t *proc) {
+	int prio = proc->prio;
+
+	proc->next = NULL;
+	if (prio_tail[prio]) {
+		prio_tail[prio]->next = proc;
+	} else {
+		prio_head[prio] = proc;
+		prio_bitmap |= 0x80000000u >> prio;
+	}
+	prio_tail[prio] = proc;
+}
+
+//-------------------------------------------------------------------
+// fp_dequeue_next --------------------------------------------------
+//-------------------------------------------------------------------
+static process_t * fp_dequeue_next(void) {
+	if (!prio_bitmap) return NULL;
+
+	int prio = __CLZ(prio_bitmap);
+	process_t *proc = prio_head[prio];
+
+	prio_head[prio] = proc->next;
+	if (!prio_head[prio]) {
+		prio_tail[prio] = NULL;
+		prio_bitmap &= ~(0x80000000u >> prio);
+	}
+	proc->next = NULL;
+	return proc;
+}
+
+//-------------------------------------------------------------------
+// fp_on_tick -------------------------------------------------------
+//-------------------------------------------------------------------
+static int fp_on_tick(process_t *cur) {
+	return prio_bitmap && (__CLZ(prio_bitmap) < cur->prio);
+}
+
+//-------------------------------------------------------------------
+// fp_remove --------------------------------------------------------
+//-------------------------------------------------------------------
+static void fp_remove(process_t *proc) {
+	int prio = proc->prio;
+	process_t * prev = NULL;
+	process_t * itr  = prio_head[prio];
+
+	while ((itr != NULL) && (itr != proc)) {
+		prev = itr;
+		itr  = itr->next;
+	}
+	if (!itr) return;
+
+	if (prev) {
+		prev->next = proc->next;
+	} else {
+		prio_head[prio] = proc->next;
+	}
+	if (prio_tail[prio] == proc) {
+		prio_tail[prio] = prev;
+	}
+	if (!prio_head[prio]) {
+		prio_bitmap &= ~(0x80000000u >> prio);
+	}
+	proc->next = NULL;
+}
+
+//-------------------------------------------------------------------
+// fp_precedes ------------------------------------------------------
+//-------------------------------------------------------------------
+static int fp_precedes(process_t *a, process_t *b) {
+	return a->prio < b->prio;
+}
+
+//-------------------------------------------------------------------
+// fp_ready ---------------------------------------------------------
+//-------------------------------------------------------------------
+static int fp_ready(void) {
+	return prio_bitmap != 0;
+}
+
+const sched_policy_t sched_policy = {
+	fp_enqueue,
+	fp_dequeue_next,
+	fp_on_tick,
+	NULL,
+	fp_remove,
+	fp_precedes,
+	fp_ready
+};
+
+#endif
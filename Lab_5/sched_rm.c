@@ -0,0 +1,86 @@
+#include "sched.h"
+
+#if SCHED_POLICY == SCHED_RM
+
+#include "shared_structs.h"
+#include "rt_heap.h"
+
+// Released real-time jobs, ordered by rate (shortest period first).
+static rt_heap_t rt_queue;
+
+//-------------------------------------------------------------------
+// rm_key -----------------------------------------------------------
+//-------------------------------------------------------------------
+// Periodic processes are ranked by period. One-shot jobs have no rate,
+// so they are ranked by their relative deadline (deadline monotonic).
+static systime_t rm_key(process_t *proc) {
+	if (proc->period) return proc->period;
+	return proc->deadline - proc->start;
+}
+
+//-------------------------------------------------------------------
+// rm_enqueue -------------------------------------------------------
+//-------------------------------------------------------------------
+static void rm_enqueue(process_t *proc) {
+	if (proc->rt == 1) {
+		rt_heap_push(&rt_queue, rm_key(proc), proc);
+	} else {
+		push_tail_process(proc);
+	}
+}
+
+//-------------------------------------------------------------------
+// rm_dequeue_next --------------------------------------------------
+//-------------------------------------------------------------------
+static process_t * rm_dequeue_next(void) {
+	process_t *proc = rt_heap_pop(&rt_queue);
+	if (!proc) {
+		proc = pop_front_process();
+	}
+	return proc;
+}
+
+//-------------------------------------------------------------------
+// rm_on_tick -------------------------------------------------------
+//-------------------------------------------------------------------
+static int rm_on_tick(process_t *cur) {
+	if (rt_queue.size == 0) return 0;
+	return (cur->rt == 0) || (rt_heap_peek_key(&rt_queue) < rm_key(cur));
+}
+
+//-------------------------------------------------------------------
+// rm_remove --------------------------------------------------------
+//-------------------------------------------------------------------
+static void rm_remove(process_t *proc) {
+	if (proc->rt == 1) {
+		rt_heap_remove(&rt_queue, proc);
+	} else {
+		remove_process(proc);
+	}
+}
+
+//-------------------------------------------------------------------
+// rm_precedes ------------------------------------------------------
+//-------------------------------------------------------------------
+static int rm_precedes(process_t *a, process_t *b) {
+	return (a->rt == 1) && ((b->rt == 0) || (rm_key(a) < rm_key(b)));
+}
+
+//-------------------------------------------------------------------
+// rm_ready ---------------------------------------------------------
+//-------------------------------------------------------------------
+static int rm_ready(void) {
+	return rt_queue.size > 0 || process_queue != NULL;
+}
+
+const sched_policy_t sched_policy = {
+	rm_enqueue,
+	rm_dequeue_next,
+	rm_on_tick,
+	NULL,
+	rm_remove,
+	rm_precedes,
+	rm_ready
+};
+
+#endif
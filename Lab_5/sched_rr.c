@@ -0,0 +1,35 @@
+#include "sched.h"
+
+#if SCHED_POLICY == SCHED_RR
+
+#include "shared_structs.h"
+
+// Every ready process, real-time or not, shares process_queue and runs
+// for one PIT0 quantum at a time.
+
+//-------------------------------------------------------------------
+// rr_precedes ------------------------------------------------------
+//-------------------------------------------------------------------
+// Nobody runs before anybody else.
+static int rr_precedes(process_t *a, process_t *b) {
+	return 0;
+}
+
+//-------------------------------------------------------------------
+// rr_ready ---------------------------------------------------------
+//-------------------------------------------------------------------
+static int rr_ready(void) {
+	return process_queue != NULL;
+}
+
+const sched_policy_t sched_policy = {
+	push_tail_process,
+	pop_front_process,
+	NULL,
+	NULL,
+	remove_process,
+	rr_precedes,
+	rr_ready
+};
+
+#endif
@@ -5,6 +5,7 @@
 #include "shared_structs.h"
 #include <stdlib.h>
 #include "realtime.h"
+#include "timer.h"
 /** Implement your structs here */
 
 /**
@@ -14,15 +15,36 @@ struct process_state {
 	unsigned int *sp;
 	unsigned int *orig_sp;
 	int n;
+	void (*f)(void);	// entry point, used to restart periodic processes
 	process_t *next;
 	int blocked;	
-	unsigned int start;
-	unsigned int deadline;
+	systime_t start;
+	systime_t deadline;
+	systime_t period;	// us between releases, 0 if not periodic
 	int rt;
+	int prio;	// fixed priority (SCHED_FP), 0 is the highest
+	int task;	// index in the admission control task set, -1 if none
+	unsigned int released_at;	// DWT cycle count at release
+	int released;	// released_at is set and the job was not dispatched yet
+	timer_node_t timer;	// pending release or sleep wake-up
+	struct lock_state *blocked_on;	// lock this process is waiting for
+	int locks_held;	// number of locks this process holds
+	unsigned int srp_level;	// SRP preemption level (relative deadline, us), 0 if not an SRP job
+	int inherited;	// rt, start, deadline, period and prio are borrowed from a lock waiter
+	systime_t quantum;	// us per PIT0 quantum, 0 for the default
+	struct {
+		int rt;
+		systime_t start;
+		systime_t deadline;
+		systime_t period;
+		int prio;
+	} base;	// own scheduling parameters while inherited is set
 };
 
 /**
- * This defines the lock structure
+ * This defines the lock structure. held is 0 when the lock is free,
+ * otherwise the owning process_t pointer, with bit 0 set when processes
+ * are waiting on blocked_queue.
  */
 typedef struct lock_state {
 	int held;
@@ -31,10 +53,12 @@ typedef struct lock_state {
 } lock_t;
 
 /**
- * This defines the conditional variable structure
+ * This defines the conditional variable structure. Waiting processes
+ * are kept on waiting in the order they must run.
  */
 typedef struct cond_var {
-
+	process_t * waiting;
+	process_t * waiting_end;
 } cond_t;
 
 #endif
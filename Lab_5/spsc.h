@@ -0,0 +1,155 @@
+/*************************************************************************
+ *
+ *  Lock-free single-producer / single-consumer ring buffer.
+ *
+ *  Safe between one interrupt handler and one process (or any two
+ *  contexts) with no locks and no interrupt masking: head is only
+ *  written by the producer, tail only by the consumer, and DMBs order
+ *  the element accesses against the index updates. Header-only.
+ *
+ **************************************************************************
+ */
+#ifndef __SPSC_H__
+#define __SPSC_H__
+
+#include "shared_structs.h"
+
+/* Set to 0 for a ring that never touches the scheduler (spsc_wait is
+   then unavailable). */
+#ifndef SPSC_WAKE_CONSUMER
+#define SPSC_WAKE_CONSUMER 1
+#endif
+
+#if SPSC_WAKE_CONSUMER
+#include "sched.h"
+#endif
+
+typedef struct spsc {
+	volatile unsigned int head;	// next element to write; producer only
+	volatile unsigned int tail;	// next element to read; consumer only
+	unsigned int mask;	// capacity - 1
+	unsigned int size;	// bytes per element
+	unsigned char *buf;	// capacity * size bytes
+#if SPSC_WAKE_CONSUMER
+	process_t * volatile waiter;	// consumer blocked in spsc_wait
+#endif
+} spsc_t;
+
+/* Initialize r over capacity elements of size bytes in buf. capacity
+   must be a power of two; buf must hold capacity * size bytes. */
+static inline void spsc_init(spsc_t *r, void *buf, unsigned int size, unsigned int capacity) {
+	r->head 	= 0;
+	r->tail 	= 0;
+	r->mask 	= capacity - 1;
+	r->size 	= size;
+	r->buf 		= (unsigned char *) buf;
+#if SPSC_WAKE_CONSUMER
+	r->waiter = NULL;
+#endif
+}
+
+/* Number of elements in r. Exact for the consumer, a lower bound for the
+   producer. */
+static inline unsigned int spsc_count(spsc_t *r) {
+	return r->head - r->tail;
+}
+
+/*------------------------------------------------------------------------
+  Producer side
+------------------------------------------------------------------------*/
+
+/* Return the slot for the next element, to be filled in place, or NULL
+   if r is full. Nothing is visible to the consumer until spsc_publish. */
+static inline void * spsc_write_slot(spsc_t *r) {
+	unsigned int head = r->head;
+	if (head - r->tail > r->mask) return NULL;
+	// The consumer is done with the slot before we overwrite it.
+	__DMB();
+	return r->buf + (head & r->mask) * r->size;
+}
+
+/* Publish the element filled in the slot from spsc_write_slot, and wake
+   the consumer if it is blocked in spsc_wait. */
+static inline void spsc_publish(spsc_t *r) {
+	// The element is written before the consumer can see it.
+	__DMB();
+	r->head = r->head + 1;
+#if SPSC_WAKE_CONSUMER
+	if (r->waiter) {
+		uint32_t m = __get_PRIMASK();
+		__disable_irq();
+		process_t *proc = r->waiter;
+		if (proc) {
+			r->waiter = NULL;
+			process_wake(proc);
+			// Preempt through PendSV, which also works from an interrupt handler.
+			if (current_process && sched_policy.precedes(proc, current_process)) {
+				process_reschedule();
+			}
+		}
+		__set_PRIMASK(m);
+	}
+#endif
+}
+
+/* Copy size bytes from elem into r. Returns -1 if r is full, 0 otherwise. */
+static inline int spsc_push(spsc_t *r, const void *elem) {
+	unsigned char *slot = (unsigned char *) spsc_write_slot(r);
+	const unsigned char *src = (const unsigned char *) elem;
+	unsigned int i;
+	if (!slot) return -1;
+	for (i = 0; i < r->size; i++) slot[i] = src[i];
+	spsc_publish(r);
+	return 0;
+}
+
+/*------------------------------------------------------------------------
+  Consumer side
+------------------------------------------------------------------------*/
+
+/* Return the oldest element, read in place, or NULL if r is empty. It
+   stays in r until spsc_consume. */
+static inline void * spsc_read_slot(spsc_t *r) {
+	unsigned int tail = r->tail;
+	if (r->head == tail) return NULL;
+	// The element is read after the index that published it.
+	__DMB();
+	return r->buf + (tail & r->mask) * r->size;
+}
+
+/* Drop the element returned by spsc_read_slot. */
+static inline void spsc_consume(spsc_t *r) {
+	// Done reading before the producer may reuse the slot.
+	__DMB();
+	r->tail = r->tail + 1;
+}
+
+/* Copy the oldest element into elem. Returns -1 if r is empty, 0 otherwise. */
+static inline int spsc_pop(spsc_t *r, void *elem) {
+	const unsigned char *slot = (const unsigned char *) spsc_read_slot(r);
+	unsigned char *dst = (unsigned char *) elem;
+	unsigned int i;
+	if (!slot) return -1;
+	for (i = 0; i < r->size; i++) dst[i] = slot[i];
+	spsc_consume(r);
+	return 0;
+}
+
+#if SPSC_WAKE_CONSUMER
+/* Block the calling process until r is not empty. Must be called from
+   the consuming process, with interrupts enabled. */
+static inline void spsc_wait(spsc_t *r) {
+	__disable_irq();
+	// With interrupts disabled, a publish either happened before this
+	// check or will see waiter set: it cannot be missed.
+	while (r->head == r->tail) {
+		r->waiter 								= current_process;
+		current_process->blocked 	= 1;
+		process_blocked();	// re-enables interrupts
+		__disable_irq();
+	}
+	__enable_irq();
+}
+#endif
+
+#endif
@@ -0,0 +1,148 @@
+#include "srp.h"
+
+#if SRP_ENABLE
+
+#include "shared_structs.h"
+#include "sched.h"
+#include "rt_heap.h"
+
+// Preemption levels are relative deadlines: a smaller value is a higher
+// level. SRP_NO_CEILING is below every level.
+#define SRP_NO_CEILING 0xFFFFFFFFu
+
+// The shared stack. It grows down from srp_stack[SRP_STACK_WORDS].
+static unsigned int srp_stack[SRP_STACK_WORDS];
+
+// Started SRP jobs, oldest first. Only the last one may run.
+static process_t * srp_active[RT_HEAP_CAPACITY];
+static int srp_depth = 0;
+
+// Ceiling of each resource, and the system ceiling saved by each srp_lock.
+static unsigned int srp_ceiling[SRP_RESOURCES];
+static unsigned int srp_ceiling_stack[SRP_RESOURCES];
+static int srp_locked = 0;
+
+// Ceiling from locked resources alone.
+static unsigned int resource_ceiling = SRP_NO_CEILING;
+
+// Jobs that were ready but could not start, waiting for the ceiling to drop.
+static process_t * srp_deferred = NULL;
+
+//-------------------------------------------------------------------
+// srp_declare ------------------------------------------------------
+//-------------------------------------------------------------------
+void srp_declare(unsigned int level, unsigned int resources) {
+	static int initialised = 0;
+	int r;
+
+	if (!initialised) {
+		for (r = 0; r < SRP_RESOURCES; r++) srp_ceiling[r] = SRP_NO_CEILING;
+		initialised = 1;
+	}
+	for (r = 0; r < SRP_RESOURCES; r++) {
+		if ((resources & (1u << r)) && level < srp_ceiling[r]) {
+			srp_ceiling[r] = level;
+		}
+	}
+}
+
+//-------------------------------------------------------------------
+// system_ceiling ---------------------------------------------------
+//-------------------------------------------------------------------
+static unsigned int system_ceiling(void) {
+	unsigned int ceiling = resource_ceiling;
+	if (srp_depth > 0 && srp_active[srp_depth - 1]->srp_level < ceiling) {
+		ceiling = srp_active[srp_depth - 1]->srp_level;
+	}
+	return ceiling;
+}
+
+//-------------------------------------------------------------------
+// srp_blocked ------------------------------------------------------
+//-------------------------------------------------------------------
+int srp_blocked(process_t *proc) {
+	if (!proc->srp_level) return 0;
+	// Started: only the job on top of the shared stack may run.
+	if (proc->sp) return proc != srp_active[srp_depth - 1];
+	// Not started: its level must be above the system ceiling.
+	return proc->srp_level >= system_ceiling();
+}
+
+//-------------------------------------------------------------------
+// srp_defer --------------------------------------------------------
+//-------------------------------------------------------------------
+void srp_defer(process_t *proc) {
+	proc->next 		= srp_deferred;
+	srp_deferred 	= proc;
+}
+
+//-------------------------------------------------------------------
+// readmit ----------------------------------------------------------
+//-------------------------------------------------------------------
+// The system ceiling dropped: hand deferred jobs back to the policy.
+// Returns non-zero if there were any.
+static int readmit(void) {
+	int any = (srp_deferred != NULL);
+
+	while (srp_deferred) {
+		process_t *proc = srp_deferred;
+		srp_deferred = proc->next;
+		process_ready(proc);
+	}
+	return any;
+}
+
+//-------------------------------------------------------------------
+// srp_start --------------------------------------------------------
+//-------------------------------------------------------------------
+unsigned int * srp_start(process_t *proc) {
+	unsigned int *top = srp_depth ? srp_active[srp_depth - 1]->sp : &srp_stack[SRP_STACK_WORDS];
+
+	// Keep the new frame 8-byte aligned.
+	top = (unsigned int *) ((unsigned int) top & ~7u);
+	if (top - PROCESS_FRAME_WORDS - SRP_JOB_WORDS < srp_stack) {
+		return NULL;
+	}
+
+	srp_active[srp_depth++] = proc;
+	return process_stack_reset(top - PROCESS_FRAME_WORDS, proc->f);
+}
+
+//-------------------------------------------------------------------
+// srp_complete -----------------------------------------------------
+//-------------------------------------------------------------------
+void srp_complete(process_t *proc) {
+	srp_depth--;
+	proc->sp = NULL;
+	readmit();
+}
+
+//-------------------------------------------------------------------
+// srp_lock ---------------------------------------------------------
+//-------------------------------------------------------------------
+void srp_lock(int r) {
+	uint32_t m = __get_PRIMASK();
+	__disable_irq();
+	srp_ceiling_stack[srp_locked++] = resource_ceiling;
+	if (srp_ceiling[r] < resource_ceiling) {
+		resource_ceiling = srp_ceiling[r];
+	}
+	__set_PRIMASK(m);
+}
+
+//-------------------------------------------------------------------
+// srp_unlock -------------------------------------------------------
+//-------------------------------------------------------------------
+void srp_unlock(int r) {
+	uint32_t m = __get_PRIMASK();
+	__disable_irq();
+	resource_ceiling = srp_ceiling_stack[--srp_locked];
+	// A job held back by this ceiling may now preempt the caller: the
+	// switch happens once interrupts are enabled again.
+	if (readmit()) {
+		process_reschedule();
+	}
+	__set_PRIMASK(m);
+}
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef __SRP_H__
+#define __SRP_H__
+
+#include "3140_concur.h"
+#include "realtime.h"
+
+/**
+ * Stack Resource Policy. Build with -DSRP_ENABLE=1 to enable.
+ *
+ * SRP jobs are real-time jobs created with process_rt_create_srp. They
+ * have no stack of their own: each one runs to completion on a single
+ * shared stack, nested above any SRP job it preempted, so the RAM cost of
+ * a job is its process_t alone.
+ *
+ * Every SRP job gets a preemption level from its relative deadline (a
+ * shorter deadline is a higher level), and every resource a ceiling: the
+ * highest level of the jobs that declared it. A job only starts once its
+ * level is above the system ceiling (the ceilings of the locked resources
+ * and the level of the SRP job on top of the shared stack). This makes
+ * srp_lock deadlock-free and lets a job be blocked at most once, before
+ * it starts. SRP jobs must never block (no l_lock, no waiting).
+ */
+#ifndef SRP_ENABLE
+#define SRP_ENABLE 0
+#endif
+
+/* Size of the shared stack, in words. */
+#ifndef SRP_STACK_WORDS
+#define SRP_STACK_WORDS 1024
+#endif
+
+/* Words a job needs on the shared stack beyond its initial frame. A job is
+   not started until this much room is left. */
+#ifndef SRP_JOB_WORDS
+#define SRP_JOB_WORDS 64
+#endif
+
+/* Number of SRP resources; resource r is bit r of a resource mask. */
+#define SRP_RESOURCES 32
+
+#if SRP_ENABLE
+
+/* Create an SRP job out of the function f, released at start and due
+ * deadline after its release. A non-NULL period makes it periodic.
+ * resources is the mask of SRP resources it may lock. Returns -1 if
+ * unable to malloc a new process_t or the real-time queue is full, 0
+ * otherwise.
+ */
+int process_rt_create_srp(void (*f)(void), realtime_t *start, realtime_t *deadline, realtime_t *period, unsigned int resources);
+
+/* Lock and unlock SRP resource r. Never blocks. Resources must be
+   unlocked in the reverse order they were locked, and are only for SRP
+   jobs. */
+void srp_lock(int r);
+void srp_unlock(int r);
+
+/*------------------------------------------------------------------------
+  Used by process.c. All called with interrupts disabled.
+------------------------------------------------------------------------*/
+
+/* Record that a job with relative deadline level uses resources. */
+void srp_declare(unsigned int level, unsigned int resources);
+
+/* Return non-zero if proc may not run now. Such a job must be handed to
+   srp_defer instead of being run. */
+int srp_blocked(process_t *proc);
+
+/* Keep proc aside until the system ceiling drops. */
+void srp_defer(process_t *proc);
+
+/* Build the initial frame of proc on the shared stack and make it the top
+   job. Returns the new SP, or NULL if the shared stack is out of room. */
+unsigned int * srp_start(process_t *proc);
+
+/* Pop proc, which just finished, off the shared stack. */
+void srp_complete(process_t *proc);
+
+#endif /* SRP_ENABLE */
+
+#endif
@@ -0,0 +1,197 @@
+/*************************************************************************
+ * Condition variable test
+ * 
+ * producer: puts ITEMS values 1..ITEMS in a SLOTS-deep buffer
+ * consumer: takes them out and checks they arrive in order
+ *
+ *   The buffer is much smaller than the number of items, so both sides
+ *   wait on condition variables (not_full / not_empty) many times over.
+ *   A lost wake-up would hang the test with both processes blocked. The
+ *   consumer toggles the blue LED for every item.
+ *
+ * waiter:     ^ holds l while signaller blocks on it, then waits on ready v
+ * signaller:  ^ gets l handed over by c_wait's release, signals ready    v
+ *
+ *   Forces every c_signal into the window between c_wait releasing l and
+ *   the waiter being switched out: the signaller is the waiter on l, so
+ *   the release inside c_wait is what makes it ready. A signal lost there
+ *   hangs the test. handoffs counts the rounds that hit the window.
+ *
+ * sleeper x WAITERS: ^ wait on wake until go is set v
+ * broadcaster:       ^ broadcasts SPURIOUS times with go still 0, then sets it v
+ *
+ *   Every waiter must wake for each broadcast, recheck go, and wait again:
+ *   it counts SPURIOUS + 1 wake-ups and never gets past its loop early.
+ *
+ *   At the end, the LED is green if all three parts passed, red otherwise.
+ * 
+ ************************************************************************/
+ 
+#include "utils.h"
+#include "3140_concur.h"
+#include "lock.h"
+
+/* Stack space for processes */
+#define STACK 60
+
+/* Buffer depth and number of items to pass through it */
+#define SLOTS 	4
+#define ITEMS 	200
+
+lock_t l;
+cond_t not_full;
+cond_t not_empty;
+
+int buffer[SLOTS];
+int head 	= 0;
+int count = 0;
+
+/* Rounds of the lost wake-up test, broadcasts of the spurious one */
+#define ROUNDS 		200
+#define SPURIOUS 	20
+#define WAITERS 	3
+
+cond_t ready;
+int flag 			= 0;
+int handoffs 	= 0;
+
+cond_t wake;
+int go 				= 0;
+int parked 		= 0;
+int wakeups[WAITERS];
+
+/* Number of items received out of order, or wrong wake-up counts */
+int errors = 0;
+
+void producer(void) {
+	int i;
+	for (i=1; i<=ITEMS; i++) {
+		l_lock(&l);
+		while (count == SLOTS) {
+			c_wait(&l, &not_full);
+		}
+		buffer[(head + count) % SLOTS] = i;
+		count++;
+		c_signal(&l, &not_empty);
+		l_unlock(&l);
+	}
+}
+
+void consumer(void) {
+	int i, v;
+	for (i=1; i<=ITEMS; i++) {
+		l_lock(&l);
+		while (count == 0) {
+			c_wait(&l, &not_empty);
+		}
+		v = buffer[head];
+		head = (head + 1) % SLOTS;
+		count--;
+		c_signal(&l, &not_full);
+		l_unlock(&l);
+
+		if (v != i) errors++;
+		LEDBlue_Toggle();
+	}
+}
+
+void waiter(void) {
+	int i;
+	for (i=0; i<ROUNDS; i++) {
+		l_lock(&l);
+		process_blocked();	// yield: the signaller blocks on l
+		while (!flag) {
+			c_wait(&l, &ready);
+		}
+		flag = 0;
+		l_unlock(&l);
+	}
+}
+
+void signaller(void) {
+	int i;
+	for (i=0; i<ROUNDS; i++) {
+		l_lock(&l);
+		// Handed over by c_wait: the waiter must already be on ready.
+		if (c_waiting(&l, &ready)) handoffs++;
+		flag = 1;
+		c_signal(&l, &ready);
+		l_unlock(&l);
+		process_blocked();	// yield: let the waiter take the next round
+	}
+}
+
+void sleeper(int id) {
+	l_lock(&l);
+	while (!go) {
+		parked++;
+		c_wait(&l, &wake);
+		parked--;
+		wakeups[id]++;
+	}
+	l_unlock(&l);
+	if (wakeups[id] != SPURIOUS + 1) errors++;
+}
+
+void sleeper_0(void) { sleeper(0); }
+void sleeper_1(void) { sleeper(1); }
+void sleeper_2(void) { sleeper(2); }
+
+void broadcaster(void) {
+	int sent = 0;
+	while (sent <= SPURIOUS) {
+		l_lock(&l);
+		// Only broadcast once every sleeper is back in c_wait.
+		if (parked == WAITERS) {
+			if (sent == SPURIOUS) go = 1;
+			c_broadcast(&l, &wake);
+			sent++;
+		}
+		l_unlock(&l);
+		process_blocked();
+	}
+}
+
+/*--------------------------------------------*/
+/* Main function - start concurrent execution */
+/*--------------------------------------------*/
+int main(void) {	
+	 
+	LED_Initialize();
+	l_init(&l);
+	c_init(&l, &not_full);
+	c_init(&l, &not_empty);
+
+    /* Create processes */ 
+	if (process_create(consumer, STACK) < 0) { return -1; }
+	if (process_create(producer, STACK) < 0) { return -1; }
+
+    /* Launch concurrent execution */
+	process_start();
+
+    /* Signals in the release-and-park window */
+	c_init(&l, &ready);
+	if (process_create(waiter, STACK) < 0) { return -1; }
+	if (process_create(signaller, STACK) < 0) { return -1; }
+	process_start();
+
+    /* Spurious wake-ups */
+	c_init(&l, &wake);
+	if (process_create(sleeper_0, STACK) < 0) { return -1; }
+	if (process_create(sleeper_1, STACK) < 0) { return -1; }
+	if (process_create(sleeper_2, STACK) < 0) { return -1; }
+	if (process_create(broadcaster, STACK) < 0) { return -1; }
+	process_start();
+	if (handoffs == 0) errors++;
+
+  LED_Off();
+	if (errors == 0) {
+		LEDGreen_On();
+	} else {
+		LEDRed_On();
+	}
+	
+	/* Hang out in infinite loop (so we can inspect variables if we want) */ 
+	while (1);
+	return 0;
+}
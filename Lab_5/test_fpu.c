@@ -0,0 +1,99 @@
+/*************************************************************************
+ * FPU context test
+ *
+ * int_a, int_b: ^ yield to each other ROUNDS times, integer only v
+ * fp_a, fp_b:   ^ same, but each keeps a float sum live across yields v
+ *
+ *   The two pairs run one after the other. Each pair measures with the
+ *   DWT cycle counter the average cost of a context switch (half of a
+ *   yield round trip): int_switch for processes that never touched the
+ *   FPU, fp_switch for processes whose S0-S31 must be saved. Check both
+ *   in the debugger. The float processes add different steps, so a
+ *   switch that loses or mixes up FP registers shows as a wrong sum.
+ *   The LED ends green if both sums are right, red otherwise.
+ *
+ ************************************************************************/
+
+#include "utils.h"
+#include "3140_concur.h"
+
+/* Stack space for processes */
+#define STACK 		60
+#define FP_STACK 	(STACK + PROCESS_FPU_FRAME_WORDS)
+
+#define ROUNDS 	1000
+
+/* Average cycles per context switch */
+unsigned int int_switch = 0;
+unsigned int fp_switch 	= 0;
+
+int errors = 0;
+
+/*------------------*/
+/* Helper functions */
+/*------------------*/
+unsigned int yield_rounds(void) {
+	int i;
+	unsigned int start = DWT->CYCCNT;
+	for (i=0; i<ROUNDS; i++) {
+		process_blocked();
+	}
+	return (DWT->CYCCNT - start) / (2 * ROUNDS);
+}
+
+void int_a(void) {
+	int_switch = yield_rounds();
+}
+
+void int_b(void) {
+	yield_rounds();
+}
+
+void fp_sum(float step) {
+	int i;
+	float sum = 0.0f;
+	unsigned int start = DWT->CYCCNT;
+	for (i=0; i<ROUNDS; i++) {
+		sum += step;
+		process_blocked();
+	}
+	if (step == 0.5f) fp_switch = (DWT->CYCCNT - start) / (2 * ROUNDS);
+	if (sum != step * ROUNDS) errors++;
+}
+
+void fp_a(void) {
+	fp_sum(0.5f);
+}
+
+void fp_b(void) {
+	fp_sum(0.25f);
+}
+
+/*--------------------------------------------*/
+/* Main function - start concurrent execution */
+/*--------------------------------------------*/
+int main(void) {
+
+	LED_Initialize();
+
+    /* Integer-only processes */
+	if (process_create(int_a, STACK) < 0) { return -1; }
+	if (process_create(int_b, STACK) < 0) { return -1; }
+	process_start();
+
+    /* Floating-point processes */
+	if (process_create(fp_a, FP_STACK) < 0) { return -1; }
+	if (process_create(fp_b, FP_STACK) < 0) { return -1; }
+	process_start();
+
+  LED_Off();
+	if (errors == 0) {
+		LEDGreen_On();
+	} else {
+		LEDRed_On();
+	}
+
+	/* Hang out in infinite loop (so we can inspect variables if we want) */
+	while (1);
+	return 0;
+}
@@ -0,0 +1,108 @@
+/*************************************************************************
+ * Priority inversion test
+ * 
+ * pL: ^r r r___________r r r v
+ * pH: _^  (blocked)     b v
+ * pM: ___^              (waits)  g g g g g g v
+ *
+ *   pL (late deadline) takes the lock and blinks red. pH (early deadline)
+ *   is released, preempts pL and blocks on the lock. pM (middle deadline,
+ *   no lock) is released while pL still holds the lock.
+ *
+ *   With priority inheritance (the default), pL runs with pH's deadline
+ *   until it unlocks, so pM cannot preempt it: pH gets the lock, blinks
+ *   blue and meets its deadline. process_deadline_miss stays 0 and main
+ *   ends with the green LED on.
+ *
+ *   Built with -DLOCK_PRIO_INHERIT=0, pM preempts pL and runs all of its
+ *   long green sequence while pH waits, so pH misses its deadline and
+ *   main ends with the red LED on.
+ * 
+ ************************************************************************/
+ 
+#include "utils.h"
+#include "3140_concur.h"
+#include "realtime.h"
+#include "lock.h"
+
+/* Stack space for processes */
+#define RT_STACK  60
+ 
+/*--------------------------------------*/
+/* Time structs for real-time processes */
+/*--------------------------------------*/
+
+/* Release times */
+realtime_t t_pL = {0, 0};
+realtime_t t_pH = {0, 500};
+realtime_t t_pM = {1, 0};
+
+/* Relative deadlines */
+realtime_t d_pL = {60, 0};
+realtime_t d_pH = {6, 0};
+realtime_t d_pM = {40, 0};
+
+lock_t l;
+ 
+/*------------------*/
+/* Helper functions */
+/*------------------*/
+void shortDelay(){delay();}
+void mediumDelay() {delay(); delay();}
+
+void pL(void) {
+	int i;
+	l_lock(&l);
+	for (i=0; i<6;i++){
+	LEDRed_On();
+	shortDelay();
+	LED_Off();
+	shortDelay();
+	}
+	l_unlock(&l);
+}
+
+void pH(void) {
+	l_lock(&l);
+	LEDBlue_On();
+	shortDelay();
+	LED_Off();
+	l_unlock(&l);
+}
+
+void pM(void) {
+	int i;
+	for (i=0; i<10;i++){
+	LEDGreen_On();
+	mediumDelay();
+	LED_Off();
+	mediumDelay();
+	}
+}
+
+/*--------------------------------------------*/
+/* Main function - start concurrent execution */
+/*--------------------------------------------*/
+int main(void) {	
+	 
+	LED_Initialize();
+	l_init(&l);
+
+    /* Create processes */ 
+	if (process_rt_create(pL, RT_STACK, &t_pL, &d_pL) < 0) { return -1; }
+	if (process_rt_create(pH, RT_STACK, &t_pH, &d_pH) < 0) { return -1; }
+	if (process_rt_create(pM, RT_STACK, &t_pM, &d_pM) < 0) { return -1; }
+
+    /* Launch concurrent execution */
+	process_start();
+
+	if (process_deadline_miss == 0) {
+		LEDGreen_On();
+	} else {
+		LEDRed_On();
+	}
+	
+	/* Hang out in infinite loop (so we can inspect variables if we want) */ 
+	while (1);
+	return 0;
+}
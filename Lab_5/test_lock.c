@@ -0,0 +1,104 @@
+/*************************************************************************
+ * Lock test
+ * 
+ * p1: ^r r r r ____________b b b b v
+ * p2: ^______ g g g g_____________v
+ *
+ *   Both processes take the same lock around their blinking, so their
+ *   LED sequences never interleave even though they are preempted.
+ *
+ *   Before blinking, p1 measures the cost of an uncontended l_lock and
+ *   l_unlock with the DWT cycle counter (the best of ROUNDS tries, so a
+ *   preemption in the middle does not count); check lock_cycles and
+ *   unlock_cycles in the debugger.
+ * 
+ ************************************************************************/
+ 
+#include "utils.h"
+#include "3140_concur.h"
+#include "lock.h"
+
+/* Stack space for processes */
+#define STACK 60
+
+/* Number of lock/unlock pairs timed by p1 */
+#define ROUNDS 1000
+
+lock_t l;
+
+/* Cost of an uncontended lock and unlock, in core cycles */
+unsigned int lock_cycles 		= 0xFFFFFFFF;
+unsigned int unlock_cycles 	= 0xFFFFFFFF;
+
+/*------------------*/
+/* Helper functions */
+/*------------------*/
+void shortDelay(){delay();}
+
+void p1(void) {
+	int i;
+	unsigned int t0, t1, t2;
+
+	/* Time the uncontended fast path */
+	for (i=0; i<ROUNDS; i++) {
+		t0 = DWT->CYCCNT;
+		l_lock(&l);
+		t1 = DWT->CYCCNT;
+		l_unlock(&l);
+		t2 = DWT->CYCCNT;
+		if (t1 - t0 < lock_cycles) 		lock_cycles 	= t1 - t0;
+		if (t2 - t1 < unlock_cycles) 	unlock_cycles = t2 - t1;
+	}
+
+	l_lock(&l);
+	for (i=0; i<4;i++){
+	LEDRed_On();
+	shortDelay();
+	LED_Off();
+	shortDelay();
+	}
+	l_unlock(&l);
+	
+	l_lock(&l);
+	for (i=0; i<4;i++){
+	LEDBlue_On();
+	shortDelay();
+	LED_Off();
+	shortDelay();
+	}
+	l_unlock(&l);
+}
+
+void p2(void) {
+	int i;
+	l_lock(&l);
+	for (i=0; i<4;i++){
+	LEDGreen_On();
+	shortDelay();
+	LED_Off();
+	shortDelay();
+	}
+	l_unlock(&l);
+}
+
+/*--------------------------------------------*/
+/* Main function - start concurrent execution */
+/*--------------------------------------------*/
+int main(void) {	
+	 
+	LED_Initialize();
+	l_init(&l);
+
+    /* Create processes */ 
+	if (process_create(p1, STACK) < 0) { return -1; }
+	if (process_create(p2, STACK) < 0) { return -1; }
+
+    /* Launch concurrent execution */
+	process_start();
+
+  LED_Off();
+	
+	/* Hang out in infinite loop (so we can inspect variables if we want) */ 
+	while (1);
+	return 0;
+}
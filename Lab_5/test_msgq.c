@@ -0,0 +1,95 @@
+/*************************************************************************
+ * Message queue test
+ * 
+ * sender:   ^ sends ITEMS samples through a DEPTH-slot queue v
+ * receiver: ^ receives them and checks sequence numbers and sums v
+ *
+ *   Messages are filled in place in the queue's slots and read in place
+ *   by the receiver, with no copy. The queue is shallow, so the sender
+ *   often finds it full and yields, and the receiver often blocks in
+ *   mq_receive. The red LED toggles per message; at the end the LED is
+ *   green if every message arrived intact and in order, red otherwise.
+ * 
+ ************************************************************************/
+ 
+#include "utils.h"
+#include "3140_concur.h"
+#include "msgq.h"
+
+/* Stack space for processes */
+#define STACK 60
+
+/* Queue depth and number of messages to send */
+#define DEPTH 	3
+#define ITEMS 	100
+
+typedef struct {
+	unsigned int seq;
+	int sample[4];
+	int sum;
+} sample_msg_t;
+
+sample_msg_t slots[DEPTH];
+unsigned char slot_state[DEPTH];
+msgq_t q;
+
+/* Number of messages received out of order or corrupted */
+int errors = 0;
+
+void sender(void) {
+	unsigned int i;
+	int j;
+	for (i=0; i<ITEMS; i++) {
+		sample_msg_t *msg;
+		while ((msg = mq_reserve(&q)) == NULL) {
+			process_blocked();	// full: let the receiver catch up
+		}
+		msg->seq = i;
+		msg->sum = 0;
+		for (j=0; j<4; j++) {
+			msg->sample[j] = i * j;
+			msg->sum += msg->sample[j];
+		}
+		mq_commit(&q, msg);
+	}
+}
+
+void receiver(void) {
+	unsigned int i;
+	for (i=0; i<ITEMS; i++) {
+		sample_msg_t *msg = mq_receive(&q);
+		if (msg->seq != i ||
+		    msg->sum != msg->sample[0] + msg->sample[1] + msg->sample[2] + msg->sample[3]) {
+			errors++;
+		}
+		mq_release(&q, msg);
+		LEDRed_Toggle();
+	}
+}
+
+/*--------------------------------------------*/
+/* Main function - start concurrent execution */
+/*--------------------------------------------*/
+int main(void) {	
+	 
+	LED_Initialize();
+	mq_init(&q, slots, slot_state, sizeof(sample_msg_t), DEPTH);
+
+    /* Create processes */ 
+	if (process_create(receiver, STACK) < 0) { return -1; }
+	if (process_create(sender, STACK) < 0) { return -1; }
+
+    /* Launch concurrent execution */
+	process_start();
+
+  LED_Off();
+	if (errors == 0) {
+		LEDGreen_On();
+	} else {
+		LEDRed_On();
+	}
+	
+	/* Hang out in infinite loop (so we can inspect variables if we want) */ 
+	while (1);
+	return 0;
+}
@@ -0,0 +1,90 @@
+/*************************************************************************
+ * Periodic process test
+ * 
+ * pNRT: ^r r r r r r r r ...
+ * pRT1: ^__g____g____g____g ...
+ *
+ *   You should see the sequence of processes depicted above:
+ *     - Periodic real-time process pRT1 is released every 2 seconds,
+ *       starting at 1 second, and blinks the green LED once per job.
+ *     - Non real-time process pNRT blinks the red LED whenever pRT1
+ *       is not running.
+ * 
+ *   The same process_t and stack are reused for every job of pRT1, so
+ *   the heap usage does not grow. process_deadline_met should count up
+ *   by one every period if you check in the debugger.
+ * 
+ ************************************************************************/
+ 
+#include "utils.h"
+#include "3140_concur.h"
+#include "realtime.h"
+
+/*--------------------------*/
+/* Parameters for test case */
+/*--------------------------*/
+
+ 
+/* Stack space for processes */
+#define NRT_STACK 40
+#define RT_STACK  50
+ 
+/*--------------------------------------*/
+/* Time structs for real-time processes */
+/*--------------------------------------*/
+
+/* Constants used for 'work' and 'deadline's */
+realtime_t t_1sec = {1, 0};
+realtime_t t_2sec = {2, 0};
+
+/* Process start time */
+realtime_t t_pRT1 = {1, 0};
+ 
+/*------------------*/
+/* Helper functions */
+/*------------------*/
+void shortDelay(){delay();}
+void mediumDelay() {delay(); delay();}
+
+/*----------------------------------------------------
+ * Non real-time process
+ *----------------------------------------------------*/
+ 
+void pNRT(void) {
+	int i;
+	for (i=0; i<20;i++){
+	LEDRed_On();
+	shortDelay();
+	LEDRed_Toggle();
+	shortDelay();
+	}
+}
+
+/*-------------------
+ * Periodic real-time process
+ *-------------------*/
+
+void pRT1(void) {
+	LEDGreen_On();
+	shortDelay();
+	LEDGreen_Toggle();
+}
+
+/*--------------------------------------------*/
+/* Main function - start concurrent execution */
+/*--------------------------------------------*/
+int main(void) {	
+	 
+	LED_Initialize();
+
+    /* Create processes */ 
+	  if (process_create(pNRT, NRT_STACK) < 0) { return -1; }
+		if (process_rt_periodic(pRT1, RT_STACK, &t_pRT1, &t_1sec, &t_2sec) < 0) { return -1; }
+
+    /* Launch concurrent execution (never returns: pRT1 runs forever) */
+	process_start();
+
+	/* Hang out in infinite loop (so we can inspect variables if we want) */ 
+	while (1);
+	return 0;
+}
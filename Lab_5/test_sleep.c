@@ -0,0 +1,92 @@
+/*************************************************************************
+ * Sleep test
+ * 
+ * pRed:   toggles the red LED every 500 ms, 10 times
+ * pBlue:  toggles the blue LED every 700 ms, 10 times
+ *
+ *   Both processes sleep between toggles instead of calling delay(), so
+ *   the CPU is idle most of the time: check process_idle_time in the
+ *   debugger, it should be close to the total run time (about 7 s).
+ *   late_wakeups counts wake-ups more than one tick after the requested
+ *   time; the LED ends green if there were none, red otherwise.
+ *   timer_irqs_per_sec and timer_irq_ppm give the cost of the event timer
+ *   over the run (interrupts a second, and millionths of the CPU spent in
+ *   its handler), to compare with the 1000 interrupts a second of a
+ *   periodic 1 kHz tick.
+ * 
+ ************************************************************************/
+ 
+#include "utils.h"
+#include "3140_concur.h"
+#include "realtime.h"
+
+/* Stack space for processes */
+#define STACK 60
+
+int late_wakeups = 0;
+
+/* Event timer cost over the run */
+unsigned int timer_irqs_per_sec = 0;
+unsigned int timer_irq_ppm 			= 0;
+
+/*------------------*/
+/* Helper functions */
+/*------------------*/
+unsigned int now_ms(void) {
+	realtime_t now = current_time;	// one snapshot for both fields
+	return 1000*now.sec + now.msec;
+}
+
+void blink_every(void (*toggle)(void), unsigned int period_ms) {
+	int i;
+	realtime_t wake;
+	unsigned int next = now_ms();
+
+	for (i=0; i<10; i++) {
+		next += period_ms;
+		wake.sec 	= next / 1000;
+		wake.msec = next % 1000;
+		process_sleep_until(&wake);
+		if (now_ms() > next + 1) late_wakeups++;
+		toggle();
+	}
+}
+
+void pRed(void) {
+	blink_every(LEDRed_Toggle, 500);
+}
+
+void pBlue(void) {
+	blink_every(LEDBlue_Toggle, 700);
+}
+
+/*--------------------------------------------*/
+/* Main function - start concurrent execution */
+/*--------------------------------------------*/
+int main(void) {	
+	 
+	LED_Initialize();
+
+    /* Create processes */ 
+	if (process_create(pRed, STACK) < 0) { return -1; }
+	if (process_create(pBlue, STACK) < 0) { return -1; }
+
+    /* Launch concurrent execution */
+	process_start();
+
+	unsigned int run_ms = (unsigned int) (process_time() / 1000);
+	timer_irqs_per_sec 	= timer_irq_count * 1000 / run_ms;
+	timer_irq_ppm 			= (unsigned int) ((unsigned long long) timer_irq_cycles * 1000000 /
+	                      ((unsigned long long) run_ms * (DEFAULT_SYSTEM_CLOCK / 1000)));
+
+  LED_Off();
+	if (late_wakeups == 0) {
+		LEDGreen_On();
+	} else {
+		LEDRed_On();
+	}
+	
+	/* Hang out in infinite loop (so we can inspect variables if we want) */ 
+	while (1);
+	return 0;
+}
@@ -0,0 +1,126 @@
+/*************************************************************************
+ * Timing wheel benchmark
+ * 
+ *   For 10, 100 and 1000 pending timers, measures with the DWT cycle
+ *   counter the average cost of:
+ *     - arming a timer in a timer_wheel_t, and in a sorted list (the way
+ *       a sorted release queue does it),
+ *     - expiring them all: timer_advance up to the last expiry for the
+ *       wheel, popping the head of the list for the list.
+ *   Expiry times are pseudo-random within 10 s, as for sleeps and
+ *   releases. Check wheel_add, list_add, wheel_expire and list_expire in
+ *   the debugger (cycles per timer, one entry per timer count). The LED
+ *   ends green if every timer fired exactly once, in order, red otherwise.
+ *   No processes are run.
+ * 
+ ************************************************************************/
+ 
+#include "utils.h"
+#include "3140_concur.h"
+#include "timer.h"
+
+#define MAX_TIMERS 	1000
+#define SPAN_MS 		10000
+
+const unsigned int counts[3] = {10, 100, 1000};
+
+/* Cycles per timer, for each entry of counts */
+unsigned int wheel_add[3], list_add[3];
+unsigned int wheel_expire[3], list_expire[3];
+
+timer_node_t nodes[MAX_TIMERS];
+timer_wheel_t wheel;
+timer_node_t *list;
+
+int fired 	= 0;
+int errors 	= 0;
+unsigned int last_fired;
+
+/*------------------*/
+/* Helper functions */
+/*------------------*/
+unsigned int seed = 1;
+unsigned int next_random(void) {
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+void fire(timer_node_t *t) {
+	if (t->expires != wheel.now || t->expires < last_fired) errors++;
+	last_fired = t->expires;
+	fired++;
+}
+
+void list_insert(timer_node_t *t) {
+	timer_node_t **itr = &list;
+	while (*itr && (*itr)->expires <= t->expires) itr = &(*itr)->next;
+	t->next = *itr;
+	*itr 		= t;
+}
+
+void bench(int k) {
+	unsigned int n = counts[k];
+	unsigned int i, t0, last = 0;
+
+	/* Wheel */
+	timer_wheel_init(&wheel, 0);
+	seed = 1;
+	t0 = DWT->CYCCNT;
+	for (i=0; i<n; i++) {
+		unsigned int e = 1 + next_random() % SPAN_MS;
+		timer_init(&nodes[i], fire);
+		timer_add(&wheel, &nodes[i], e);
+		if (e > last) last = e;
+	}
+	wheel_add[k] = (DWT->CYCCNT - t0) / n;
+
+	fired 			= 0;
+	last_fired 	= 0;
+	t0 = DWT->CYCCNT;
+	timer_advance(&wheel, last);
+	wheel_expire[k] = (DWT->CYCCNT - t0) / n;
+	if (fired != n) errors++;
+
+	/* Sorted list, same expiry times */
+	list = NULL;
+	seed = 1;
+	t0 = DWT->CYCCNT;
+	for (i=0; i<n; i++) {
+		nodes[i].expires = 1 + next_random() % SPAN_MS;
+		list_insert(&nodes[i]);
+	}
+	list_add[k] = (DWT->CYCCNT - t0) / n;
+
+	t0 = DWT->CYCCNT;
+	while (list) {
+		list = list->next;
+	}
+	list_expire[k] = (DWT->CYCCNT - t0) / n;
+}
+
+/*----------------*/
+/* Main function  */
+/*----------------*/
+int main(void) {	
+	int k;
+	 
+	LED_Initialize();
+
+	/* Start the DWT cycle counter */
+	CoreDebug->DEMCR 	|= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL 				|= DWT_CTRL_CYCCNTENA_Msk;
+
+	for (k=0; k<3; k++) {
+		bench(k);
+	}
+
+	if (errors == 0) {
+		LEDGreen_On();
+	} else {
+		LEDRed_On();
+	}
+	
+	/* Hang out in infinite loop (so we can inspect variables if we want) */ 
+	while (1);
+	return 0;
+}
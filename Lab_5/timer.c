@@ -0,0 +1,209 @@
+#include "timer.h"
+#include <fsl_device_registers.h>
+
+/*
+  Level l holds timers due less than 2^(5(l+1)) ticks from now, in slot
+  (expires >> 5l) & 31. Slots are NULL-terminated doubly-linked lists
+  threaded through the timer nodes themselves, so nothing is allocated.
+  Slot s of level l > 0 is cascaded when now reaches a multiple of 2^5l
+  with index s at that level; by then every timer in it is due within
+  the span of the levels below.
+ */
+#define TIMER_MASK 	(TIMER_SLOTS - 1)
+
+// Index of the lowest set bit of x (x != 0).
+#define lowest_bit(x) __CLZ(__RBIT(x))
+
+//-------------------------------------------------------------------
+// timer_wheel_init -------------------------------------------------
+//-------------------------------------------------------------------
+void timer_wheel_init(timer_wheel_t *w, unsigned int now) {
+	int l, s;
+
+	w->now 			= now;
+	w->count 		= 0;
+	w->overflow = NULL;
+	for (l = 0; l < TIMER_LEVELS; l++) {
+		w->occupied[l] = 0;
+		for (s = 0; s < TIMER_SLOTS; s++) {
+			w->slots[l][s] = NULL;
+		}
+	}
+}
+
+//-------------------------------------------------------------------
+// timer_init -------------------------------------------------------
+//-------------------------------------------------------------------
+void timer_init(timer_node_t *t, void (*fire)(timer_node_t *t)) {
+	t->next 		= NULL;
+	t->prev 		= NULL;
+	t->pending 	= 0;
+	t->fire 		= fire;
+}
+
+//-------------------------------------------------------------------
+// place ------------------------------------------------------------
+//-------------------------------------------------------------------
+// Links t into the level and slot matching its distance from now.
+static void place(timer_wheel_t *w, timer_node_t *t) {
+	unsigned int delta = t->expires - w->now;
+	timer_node_t **head;
+	int l;
+
+	for (l = 0; l < TIMER_LEVELS; l++) {
+		if (delta < (1u << (TIMER_BITS * (l + 1)))) break;
+	}
+	if (l < TIMER_LEVELS) {
+		t->slot 	= (t->expires >> (TIMER_BITS * l)) & TIMER_MASK;
+		head 			= &w->slots[l][t->slot];
+		w->occupied[l] |= 1u << t->slot;
+	} else {
+		t->slot 	= 0;
+		head 			= &w->overflow;
+	}
+	t->level 	= l;
+	t->prev 	= NULL;
+	t->next 	= *head;
+	if (*head) (*head)->prev = t;
+	*head 		= t;
+}
+
+//-------------------------------------------------------------------
+// unlink -----------------------------------------------------------
+//-------------------------------------------------------------------
+static void detach(timer_wheel_t *w, timer_node_t *t) {
+	if (t->next) t->next->prev = t->prev;
+	if (t->prev) {
+		t->prev->next = t->next;
+	} else if (t->level < TIMER_LEVELS) {
+		w->slots[t->level][t->slot] = t->next;
+		if (!t->next) w->occupied[t->level] &= ~(1u << t->slot);
+	} else {
+		w->overflow = t->next;
+	}
+	t->next = NULL;
+	t->prev = NULL;
+}
+
+//-------------------------------------------------------------------
+// timer_add --------------------------------------------------------
+//-------------------------------------------------------------------
+void timer_add(timer_wheel_t *w, timer_node_t *t, unsigned int expires) {
+	// Already due: fire on the next tick.
+	if ((int) (expires - w->now) <= 0) expires = w->now + 1;
+	t->expires = expires;
+	t->pending = 1;
+	w->count++;
+	place(w, t);
+}
+
+//-------------------------------------------------------------------
+// timer_cancel -----------------------------------------------------
+//-------------------------------------------------------------------
+void timer_cancel(timer_wheel_t *w, timer_node_t *t) {
+	if (!t->pending) return;
+	detach(w, t);
+	t->pending = 0;
+	w->count--;
+}
+
+//-------------------------------------------------------------------
+// cascade ----------------------------------------------------------
+//-------------------------------------------------------------------
+// Moves every timer of the list *head to where it now belongs.
+static void cascade(timer_wheel_t *w, timer_node_t **head) {
+	timer_node_t *t = *head;
+	*head = NULL;
+	while (t) {
+		timer_node_t *next = t->next;
+		place(w, t);
+		t = next;
+	}
+}
+
+//-------------------------------------------------------------------
+// tick -------------------------------------------------------------
+//-------------------------------------------------------------------
+// Processes the next tick: cascade the levels that wrap, then fire the
+// level 0 slot.
+static void tick(timer_wheel_t *w) {
+	unsigned int now = ++w->now;
+	unsigned int s;
+	int l;
+
+	for (l = 1; l <= TIMER_LEVELS; l++) {
+		// Level l - 1 wrapped around: refill it from level l.
+		if (now & ((1u << (TIMER_BITS * l)) - 1)) break;
+		if (l == TIMER_LEVELS) {
+			cascade(w, &w->overflow);
+		} else {
+			s = (now >> (TIMER_BITS * l)) & TIMER_MASK;
+			w->occupied[l] &= ~(1u << s);
+			cascade(w, &w->slots[l][s]);
+		}
+	}
+
+	s = now & TIMER_MASK;
+	while (w->slots[0][s]) {
+		timer_node_t *t = w->slots[0][s];
+		detach(w, t);
+		t->pending = 0;
+		w->count--;
+		t->fire(t);
+	}
+}
+
+//-------------------------------------------------------------------
+// timer_advance ----------------------------------------------------
+//-------------------------------------------------------------------
+void timer_advance(timer_wheel_t *w, unsigned int now) {
+	unsigned int next;
+
+	while ((int) (now - w->now) > 0) {
+		// Nothing fires or cascades before next: jump straight to it.
+		if (!timer_next(w, &next) || (int) (now - next) < 0) {
+			w->now = now;
+			break;
+		}
+		w->now = next - 1;
+		tick(w);
+	}
+}
+
+//-------------------------------------------------------------------
+// timer_next -------------------------------------------------------
+//-------------------------------------------------------------------
+int timer_next(timer_wheel_t *w, unsigned int *when) {
+	unsigned int best, next, idx, rot;
+	int l, found = 0;
+
+	if (w->count == 0) return 0;
+
+	// Level 0: exact. Slots after the current one, in tick order.
+	best = 0;
+	if (w->occupied[0]) {
+		idx 	= (w->now + 1) & TIMER_MASK;
+		rot 	= (w->occupied[0] >> idx) | (idx ? w->occupied[0] << (TIMER_SLOTS - idx) : 0);
+		best 	= w->now + 1 + lowest_bit(rot);
+		found = 1;
+	}
+
+	// Higher levels: the tick their first occupied slot cascades. That
+	// can come before a level 0 timer further in the ring.
+	for (l = 1; l < TIMER_LEVELS; l++) {
+		unsigned int shift = TIMER_BITS * l;
+		if (!w->occupied[l]) continue;
+		idx 	= ((w->now >> shift) + 1) & TIMER_MASK;
+		rot 	= (w->occupied[l] >> idx) | (idx ? w->occupied[l] << (TIMER_SLOTS - idx) : 0);
+		next 	= (((w->now >> shift) + 1 + lowest_bit(rot)) << shift);
+		if (!found || (int) (next - best) < 0) best = next;
+		found = 1;
+	}
+	if (w->overflow) {
+		next = ((w->now >> (TIMER_BITS * TIMER_LEVELS)) + 1) << (TIMER_BITS * TIMER_LEVELS);
+		if (!found || (int) (next - best) < 0) best = next;
+		found = 1;
+	}
+	*when = best;
+	return found;
+}
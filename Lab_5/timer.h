@@ -0,0 +1,71 @@
+/*************************************************************************
+ *
+ *  Hierarchical timing wheel.
+ *
+ *  Four levels of 32 slots cover delays up to 2^20 ticks (about 105 s
+ *  at the default 10 kHz tick); anything later waits on an overflow
+ *  list. Adding and cancelling a timer are O(1). A timer in a higher
+ *  level is moved down (cascaded) when the level below wraps around, so
+ *  it is touched at most once per level before it fires.
+ *
+ **************************************************************************
+ */
+#ifndef __TIMER_H__
+#define __TIMER_H__
+
+#include <stddef.h>
+
+#define TIMER_LEVELS 	4
+#define TIMER_BITS 		5
+#define TIMER_SLOTS 	(1 << TIMER_BITS)
+
+typedef struct timer_node timer_node_t;
+
+struct timer_node {
+	timer_node_t *next;
+	timer_node_t *prev;
+	unsigned int expires;	// absolute tick
+	unsigned char level;	// TIMER_LEVELS for the overflow list
+	unsigned char slot;
+	unsigned char pending;
+	void (*fire)(timer_node_t *t);	// called from timer_advance once expired
+};
+
+typedef struct {
+	unsigned int now;	// last tick processed
+	unsigned int count;	// pending timers
+	unsigned int occupied[TIMER_LEVELS];	// bit s set if slot s is not empty
+	timer_node_t *slots[TIMER_LEVELS][TIMER_SLOTS];
+	timer_node_t *overflow;
+} timer_wheel_t;
+
+/*
+  None of these functions modify interrupt flags: call them with
+  interrupts disabled, or only from one interrupt handler.
+*/
+
+/* Initialize w, with now as the current tick. */
+void timer_wheel_init(timer_wheel_t *w, unsigned int now);
+
+/* Initialize t, which calls fire when it expires. */
+void timer_init(timer_node_t *t, void (*fire)(timer_node_t *t));
+
+/* Arm t to fire at tick expires. A time that has already passed fires on
+   the next tick. t must not be pending. */
+void timer_add(timer_wheel_t *w, timer_node_t *t, unsigned int expires);
+
+/* Disarm t. Does nothing if t is not pending. */
+void timer_cancel(timer_wheel_t *w, timer_node_t *t);
+
+/* Advance w up to tick now, firing every timer that expires on the way,
+   in tick order. Ticks with nothing to fire or cascade are skipped, so
+   the cost does not depend on how far now is. */
+void timer_advance(timer_wheel_t *w, unsigned int now);
+
+/* If any timer is pending, store in *when a tick at or before the first
+   expiry and return 1; return 0 otherwise. *when is exact for timers due
+   within TIMER_SLOTS ticks; further ones may need a few wake-ups to
+   cascade. */
+int timer_next(timer_wheel_t *w, unsigned int *when);
+
+#endif